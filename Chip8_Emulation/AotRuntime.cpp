@@ -0,0 +1,41 @@
+#include "AotRuntime.h"
+#include <algorithm>
+#include <iostream>
+
+//Function local so the registrars of the generated units can run in any static init order
+static std::vector< const AotModule* >& GetRegisteredModules()
+{
+	static std::vector< const AotModule* > s_aModules;
+	return s_aModules;
+}
+
+void AotRuntime::RegisterModule( const AotModule& oModule )
+{
+	if( FindModule( oModule.sHash ) != nullptr )
+	{
+		std::cerr << "ERROR::AOT::MODULE_ALREADY_REGISTERED " << oModule.sRomName << std::endl;
+		return;
+	}
+
+	GetRegisteredModules().push_back( &oModule );
+}
+
+const AotModule* AotRuntime::FindModule( const std::string& sHash )
+{
+	for( const AotModule* pModule : GetRegisteredModules() )
+	{
+		if( sHash == pModule->sHash )
+			return pModule;
+	}
+	return nullptr;
+}
+
+const AotBlock* AotRuntime::FindBlock( const AotModule& oModule,const uint16_t iStartPC )
+{
+	const AotBlock* pEnd = oModule.aBlocks + oModule.iBlockCount;
+	const AotBlock* pBlock = std::lower_bound( oModule.aBlocks,pEnd,iStartPC,[]( const AotBlock& oBlock,const uint16_t iPC ) { return oBlock.iStartPC < iPC; } );
+	if( pBlock == pEnd || pBlock->iStartPC != iStartPC )
+		return nullptr;
+
+	return pBlock;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Chip8.h"
+#include <vector>
+
+//One straight-line block of a ROM compiled ahead of time, it is only bound when the translated block has the exact same opcodes
+struct AotBlock
+{
+	uint16_t						iStartPC;
+	uint16_t						iOpcodeCount;
+	const uint16_t*					aOpcodes;
+	uint16_t						iFollowingOpcode; //Opcode after a final skip, 0 otherwise
+	JitCompiler::NativeBlock		pFunction;
+};
+
+//Everything Chip8_Recompiler produced for one ROM, the quirks it was compiled with must match the running ones
+struct AotModule
+{
+	const char*						sRomName;
+	const char*						sHash; //SHA1 of the ROM, same key as the database
+	Quirk							oQuirk;
+	const AotBlock*					aBlocks; //Sorted by iStartPC
+	size_t							iBlockCount;
+};
+
+//Bridge between the generated translation units and the machine state, nothing else should use it
+class AotRuntime
+{
+public:
+	static void						RegisterModule( const AotModule& oModule );
+	static const AotModule*			FindModule( const std::string& sHash );
+	static const AotBlock*			FindBlock( const AotModule& oModule,const uint16_t iStartPC );
+
+	//Same block shape as the runtime translation, the recompiler has to cut the code exactly where the CPU does
+	static uint32_t					ScanBlock( const Chip8& oCpu,const uint16_t iStartPC,std::vector< uint16_t >& aOpcodes,uint16_t& iFollowingOpcode ) { return Chip8::_ScanBlock( oCpu,iStartPC,aOpcodes,iFollowingOpcode ); }
+	static bool						IsSkipOpcode( const uint16_t iOpcode ) { return Chip8::_IsSkipOpcode( iOpcode ); }
+
+	static Data< uint8_t >*			GetRegisters( Chip8* pCpu ) { return pCpu->m_aRegisters; }
+	static Data< uint16_t >*		GetStack( Chip8* pCpu ) { return pCpu->m_aStack; }
+	static Data< uint8_t >&			GetSP( Chip8* pCpu ) { return pCpu->m_iSP; }
+	static Data< uint16_t >&		GetI( Chip8* pCpu ) { return pCpu->m_iI; }
+	static Data< uint16_t >&		GetPC( Chip8* pCpu ) { return pCpu->m_iPC; }
+	static Data< uint8_t >&			GetDelayTimer( Chip8* pCpu ) { return pCpu->m_iDelay_timer; }
+	static Data< uint8_t >&			GetSoundTimer( Chip8* pCpu ) { return pCpu->m_iSound_timer; }
+	static void						SetCurrentOpcode( Chip8* pCpu,const uint16_t iOpcode ) { pCpu->m_iCurrentOpcode = iOpcode; }
+
+	//Interpreter handler for the opcodes the recompiler doesn't emit, PC has to be on the opcode
+	static void						Execute( Chip8* pCpu,const uint16_t iOpcode ) { Chip8::_JitExecuteOpcode( pCpu,iOpcode ); }
+};
+
+//A generated translation unit declares one of these at namespace scope to make its module visible before main
+struct AotRegistrar
+{
+	AotRegistrar( const AotModule& oModule ) { AotRuntime::RegisterModule( oModule ); }
+};
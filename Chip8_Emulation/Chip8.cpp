@@ -2,186 +2,348 @@
 #include <fstream>
 #include <chrono>
 #include <assert.h>
-#include "Display.h"
 #include <iostream>
-#include "Input.h"
-#include "SoundManager.h"
+#include <algorithm>
 #include <string.h>
 #include <cstring>
 #include <filesystem>
 
 #include "Init_RomSettings.h"
-#ifdef DEBUG_INFO
-#include "Disassembler.h"
-#endif
+#include "AotRuntime.h"
 
 #define DEFAULT_PARENT_ROM_FOLDER "../Roms/"
 #define JMPCHECK_BEFORE_ENDING 4
-#define USE_SWITCH_BRANCH
+#define IDLE_LOOP_MAX_INSTRUCTIONS 8 //Longer loops are only checked when the database lists them
+#define IDLE_LOOP_MAX_HACK_INSTRUCTIONS 64
+#define IDLE_LOOP_MAX_FAILURES 8 //Retried every 2^failures jumps at most
+#define MAX_BLOCK_LENGTH 64
 
-int Chip8::m_iInstructionsPerFrame = 20000;
-#ifdef DEBUG_INFO
-uint16_t Chip8::m_iAdressBreakpoint = 0;
+#define DEFAULT_INSTRUCTIONS_PER_FRAME 20000
+#define GOVERNOR_WINDOW_FRAMES 60 //IPF is lowered at most once a second, raised as soon as a frame never idles
+#define GOVERNOR_MIN_IPF 10 //Same as the debugger slider, when the database gives no tickrate
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+	#define COMPUTED_GOTO_SUPPORTED
 #endif
 
-Chip8* Chip8::m_pSingleton = nullptr;
-uint8_t Chip8::iHexToIndex[ 0x66 ] = { 0 };
+//Every handler _DecodeOpcode can return, the threaded interpreter has one label per entry
+//QUIRK_HANDLER ones are templates, instantiated for each quirk specialization
+#define CHIP8_OPCODE_HANDLERS( HANDLER,QUIRK_HANDLER ) \
+	HANDLER( UNKNOWN_OPCODE ) HANDLER( CLS ) HANDLER( RET ) QUIRK_HANDLER( SCROLL_DOWN ) QUIRK_HANDLER( SCROLL_UP ) QUIRK_HANDLER( SCROLL_RIGHT ) \
+	QUIRK_HANDLER( SCROLL_LEFT ) HANDLER( QUIT ) HANDLER( LORES ) HANDLER( HIRES ) HANDLER( JMP ) HANDLER( CALL ) HANDLER( SE_VX_NN ) \
+	HANDLER( SNE_VX_NN ) HANDLER( SE_VX_VY ) HANDLER( SAVE_RANGE ) HANDLER( LOAD_RANGE ) HANDLER( LD_VX_NN ) HANDLER( ADD_VX_NN ) \
+	HANDLER( LD_VX_VY ) QUIRK_HANDLER( OR ) QUIRK_HANDLER( AND ) QUIRK_HANDLER( XOR ) HANDLER( ADD_VX_VY ) HANDLER( SUB_VX_VY ) QUIRK_HANDLER( SHR ) \
+	HANDLER( SUBN_VX_VY ) QUIRK_HANDLER( SHL ) HANDLER( SNE_VX_VY ) HANDLER( LD_I_NNN ) QUIRK_HANDLER( JMP_NNN ) HANDLER( RND ) QUIRK_HANDLER( DRAW ) \
+	HANDLER( SKP ) HANDLER( SKNP ) HANDLER( LD_I_NNNN ) HANDLER( PLANE ) HANDLER( AUDIO ) HANDLER( LD_VX_DT ) HANDLER( LD_VX_KEY ) \
+	HANDLER( LD_DT_VX ) HANDLER( LD_ST_VX ) HANDLER( ADD_I_VX ) HANDLER( LD_I_FONT ) HANDLER( LD_I_SUPER_FONT ) HANDLER( BCD ) \
+	HANDLER( AUDIO_PITCH ) QUIRK_HANDLER( LD_I_VX ) QUIRK_HANDLER( LD_VX_I ) HANDLER( SAVEFLAGS_VX ) HANDLER( LOADFLAGS_VX )
 
-std::array< std::string,7 > Chip8::m_sSupportedPlatform = { "originalChip8","hybridVIP","modernChip8","chip8x","chip48", "superchip", "xochip" };
-Quirk  Chip8::m_oCurrentQuirk = Quirk();
+#define HANDLER_ID( NAME ) Handler_##NAME,
+enum OpcodeHandlerId : uint8_t
+{
+	CHIP8_OPCODE_HANDLERS( HANDLER_ID,HANDLER_ID )
+	Handler_Count
+};
+#undef HANDLER_ID
+
+const std::array< std::string,7 > Chip8::m_sSupportedPlatform = { "originalChip8","hybridVIP","modernChip8","chip8x","chip48", "superchip", "xochip" };
 
 using namespace MemoryMap;
-void Chip8::SetROMPathFileToLoad( const KeyAccess& oKey,const std::string& sSrc )
-{
-	delete[] m_sCurrentRomLoaded;
+static_assert( START_ROM_MEMORY_ADDRESS % MEMORY_PAGE_SIZE == 0,"The ROM image is mapped page by page" );
 
-	size_t iSize = sSrc.length() + 1;
-	char* sDest = new char[ iSize ];
-	memcpy( sDest, sSrc.c_str(), iSize );
+Chip8::MemoryPage Chip8::s_aZeroPage = {};
+Chip8::InterpreterArea Chip8::s_aInterpreterArea = Chip8::_BuildInterpreterArea();
 
-	m_sCurrentRomLoaded = sDest;
+void Chip8::SetROMPathFileToLoad( const KeyAccess& oKey,const std::string& sSrc )
+{
+	m_sCurrentRomLoaded = sSrc;
 }
 
+static_assert( sizeof( Data< uint8_t > ) == 1 && sizeof( Data< uint16_t > ) == 2,"Registers, stack, I, PC, SP and timers have to fit in one cache line" );
+static_assert( std::is_trivially_copyable_v< Data< uint8_t > >,"FX55 / FX65 / 5XY2 / 5XY3 copy the register file as bytes" );
+
 Chip8::Chip8() :
 	m_iCurrentOpcode( 0 )
-	,m_iLastOpcode( 0 )
-	,m_iCountBeforeStop( 0 )
+	,m_iAddressMask( CHIP8_MEMORY_SIZE - 1 )
+	,m_iCycle( 0 )
+	,m_iInstructionsRun( 0 )
 #ifdef DEBUG_INFO
 	,m_oState( RunningState::Pause )
 #else
 	,m_oState( RunningState::Running )
 #endif
-	,m_iLastTimeUpdate( std::chrono::steady_clock::now() )
-	,m_sCurrentRomLoaded( nullptr )
-	,m_iCycle( 0 )
+	,m_oHalt( HaltState::None )
+	,m_iCountBeforeStop( 0 )
 	,m_iPreviousKeyPressed( 0xFF )
-	,m_iTimeLastFrame{}
-	,m_pInputInstance( nullptr )
-	,m_pSoundManagerInstance( nullptr )
-	,m_pDisplayInstance( nullptr )
-	,m_pCurrentOpcode( nullptr )
+	,m_iInstructionsPerFrame( DEFAULT_INSTRUCTIONS_PER_FRAME )
+	,m_iMaxInstructionsPerFrame( DEFAULT_INSTRUCTIONS_PER_FRAME )
+	,m_bIpfGovernor( false )
+#ifdef DEBUG_INFO
+	,m_iAdressBreakpoint( 0 )
+	,m_bDebuggerAttached( false )
+#endif
+	,m_pRom( std::make_shared< RomImage >() )
+	,m_iPrivatePagesUsed( 0 )
+	,m_aKeys{ 0 }
+	,m_aHostKeys{ 0 }
+	,m_iLoadCount( 0 )
+	,m_oDispatch( InterpreterDispatch::PredecodeCache )
+	,m_pQuirkSpecialization( &s_aQuirkSpecializations[ GENERIC_QUIRKS ] )
+	,m_oEngine( ExecutionEngine::Interpreter )
+	,m_pAotModule( nullptr )
+	,m_iRandomState( 0 )
+	,m_iRandomSeed( 0 )
+	,m_bFixedRandomSeed( false )
+	,m_iRandomIndex( RANDOM_BATCH_SIZE )
 	,m_bXoCHIP( false )
 {
-	m_aMainTable[ 0x0 ] = { &Chip8::x0_Dispatch };
-	m_aMainTable[ 0x1 ] = { &Chip8::JMP };
-	m_aMainTable[ 0x2 ] = { &Chip8::CALL };
-	m_aMainTable[ 0x3 ] = { &Chip8::SE_VX_NN };
-	m_aMainTable[ 0x4 ] = { &Chip8::SNE_VX_NN };
-	m_aMainTable[ 0x5 ] = { &Chip8::SE_VX_VY };
-	m_aMainTable[ 0x6 ] = { &Chip8::LD_VX_NN };
-	m_aMainTable[ 0x7 ] = { &Chip8::ADD_VX_NN };
-	m_aMainTable[ 0x8 ] = { &Chip8::x8_Dispatch };
-	m_aMainTable[ 0x9 ] = { &Chip8::SNE_VX_VY };
-	m_aMainTable[ 0xA ] = { &Chip8::LD_I_NNN };
-	m_aMainTable[ 0xB ] = { &Chip8::JMP_NNN };
-	m_aMainTable[ 0xC ] = { &Chip8::RND };
-	m_aMainTable[ 0xD ] = { &Chip8::DRAW };
-	m_aMainTable[ 0xE ] = { &Chip8::xE_Dispatch };
-	m_aMainTable[ 0xF ] = { &Chip8::xF_Dispatch };
-
-	//0x8000 - 0xE000
-	m_a0x8_Table[ 0x0 ] = { &Chip8::LD_VX_VY };
-	m_a0x8_Table[ 0x1 ] = { &Chip8::OR };
-	m_a0x8_Table[ 0x2 ] = { &Chip8::AND };
-	m_a0x8_Table[ 0x3 ] = { &Chip8::XOR };
-	m_a0x8_Table[ 0x4 ] = { &Chip8::ADD_VX_VY };
-	m_a0x8_Table[ 0x5 ] = { &Chip8::SUB_VX_VY };
-	m_a0x8_Table[ 0x6 ] = { &Chip8::SHR };
-	m_a0x8_Table[ 0x7 ] = { &Chip8::SUBN_VX_VY };
-	m_a0x8_Table[ 0x9 ] = { &Chip8::SKP };	//xE_Dispatch
-	m_a0x8_Table[ 0xA ] = { &Chip8::SKNP }; //xE_Dispatch
-	m_a0x8_Table[ 0xE ] = { &Chip8::SHL };
-
-	//0x0000 - 0xF000 - size 0xFF
-	m_a0xF_Table[ 0 ] = { &Chip8::CLS };		//0x0 //x0_Dispatch
-	m_a0xF_Table[ 1 ] = { &Chip8::LD_VX_DT };	//0x7
-	m_a0xF_Table[ 2 ] = { &Chip8::LD_VX_KEY }; //0xA
-	m_a0xF_Table[ 3 ] = { &Chip8::RET };		//0xE //x0_Dispatch
-	m_a0xF_Table[ 4 ] = { &Chip8::LD_DT_VX };	//0x15
-	m_a0xF_Table[ 5 ] = { &Chip8::LD_ST_VX };	//0x18
-	m_a0xF_Table[ 6 ] = { &Chip8::ADD_I_VX };	//0x1E
-	m_a0xF_Table[ 7 ] = { &Chip8::LD_I_FONT };	//0x29
-	m_a0xF_Table[ 8 ] = { &Chip8::BCD };		//0x33
-	m_a0xF_Table[ 9 ] = { &Chip8::LD_I_VX };	//0x55
-	m_a0xF_Table[ 10 ] = { &Chip8::LD_VX_I };	//0x65
-
-	//Hex to Index For F Table
-	iHexToIndex[ 0x00 ] = 0; iHexToIndex[ 0x07 ] = 1; iHexToIndex[ 0x0A ] = 2;
-	iHexToIndex[ 0x0E ] = 3; iHexToIndex[ 0x15 ] = 4; iHexToIndex[ 0x18 ] = 5;
-	iHexToIndex[ 0x1E ] = 6; iHexToIndex[ 0x29 ] = 7; iHexToIndex[ 0x33 ] = 8;
-	iHexToIndex[ 0x55 ] = 9; iHexToIndex[ 0x65 ] = 10;
+	_AllocateMemory( CHIP8_MEMORY_SIZE );
+	m_oScheduler.Reset( m_iCycle,m_iInstructionsPerFrame );
 }
 
 Chip8::~Chip8()
 {
-	m_pSingleton = nullptr;
-	m_aMirorMemory.fill( DecodedOpcode{} );
 }
 
 void Chip8::Init( const KeyAccess& key,const char* sROMToLoad )
 {
-	unsigned timeSeed = std::chrono::steady_clock::now().time_since_epoch().count();
-	m_iRng.seed( timeSeed );
+	_SeedRandom();
 
-	_LoadFont();
+	_AllocateMemory( CHIP8_MEMORY_SIZE );
 	_LoadROM( sROMToLoad );
+	_FlushDecodeCache();
+	_FlushBlockCache();
+
+	m_iPC = START_ROM_MEMORY_ADDRESS;
+	m_iSP = 0;
+	m_oScheduler.Reset( m_iCycle,m_iInstructionsPerFrame );
+
+	++m_iLoadCount;
+}
+
+//Nothing is read from disk and nothing is allocated once the buffers of the machine are as big as the image needs
+void Chip8::Init( const KeyAccess& key,const std::shared_ptr< const RomImage >& pImage )
+{
+	//A recycled machine may have run another ROM, it starts over from the defaults of a new one
+	_ResetMachineState();
+	m_iInstructionsPerFrame = m_iMaxInstructionsPerFrame = DEFAULT_INSTRUCTIONS_PER_FRAME;
+	m_oCurrentQuirk = Quirk();
+#ifdef DEBUG_INFO
+	m_oState = RunningState::Pause;
+#else
+	m_oState = RunningState::Running;
+#endif
+
+	_SeedRandom();
+
+	m_pRom = pImage;
+	m_sCurrentRomLoaded = pImage->sPath;
+
+	_AllocateMemory( CHIP8_MEMORY_SIZE );
+	_ApplyRomImage();
+	_FlushDecodeCache();
+	_FlushBlockCache();
 
 	m_iPC = START_ROM_MEMORY_ADDRESS;
 	m_iSP = 0;
+	m_oScheduler.Reset( m_iCycle,m_iInstructionsPerFrame );
+
+	++m_iLoadCount;
+}
+
+void Chip8::SetRandomSeed( const uint32_t iSeed )
+{
+	m_iRandomSeed = iSeed;
+	m_bFixedRandomSeed = true;
+	_SeedRandom();
+}
 
-	if( m_pSoundManagerInstance == nullptr )
-		m_pSoundManagerInstance = SoundManager::GetInstance();
-	if( m_pInputInstance == nullptr )
-		m_pInputInstance = Input::GetInstance();
-	if( m_pDisplayInstance == nullptr )
-		m_pDisplayInstance = Display::GetInstance();
+void Chip8::SetRandomSeedFromClock()
+{
+	m_bFixedRandomSeed = false;
+	_SeedRandom();
+}
+
+void Chip8::_SeedRandom()
+{
+	if( !m_bFixedRandomSeed )
+		m_iRandomSeed = static_cast< uint32_t >( std::chrono::steady_clock::now().time_since_epoch().count() );
+	m_iRandomState = m_iRandomSeed;
+	m_iRandomIndex = RANDOM_BATCH_SIZE; //Filled on the first CXNN
+}
+
+//SplitMix64, a few integer operations for 8 bytes. Bytes are taken low first so a seed gives the same run on any host
+void Chip8::_RefillRandomBytes()
+{
+	for( uint8_t i = 0; i < RANDOM_BATCH_SIZE; i += 8 )
+	{
+		m_iRandomState += 0x9E3779B97F4A7C15ull;
+		uint64_t iValue = m_iRandomState;
+		iValue = ( iValue ^ ( iValue >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+		iValue = ( iValue ^ ( iValue >> 27 ) ) * 0x94D049BB133111EBull;
+		iValue ^= iValue >> 31;
+		for( uint8_t iByte = 0; iByte < 8; ++iByte )
+			m_aRandomBytes[ i + iByte ] = static_cast< uint8_t >( iValue >> ( iByte * 8 ) );
+	}
+	m_iRandomIndex = 0;
 }
 
 void Chip8::_Reset()
 {
-	if( m_sCurrentRomLoaded == nullptr )
+	if( m_sCurrentRomLoaded.empty() )
 		return;
 
+	_ResetMachineState();
+
+	Chip8::KeyAccess oKey;
+	Init( oKey,m_sCurrentRomLoaded.c_str() );
+}
+
+void Chip8::_ResetMachineState()
+{
 	m_iI.clear();
 	m_iDelay_timer.clear();
 	m_iSound_timer.clear();
-	m_iLastOpcode = 0;
 	m_iCycle = 0;
+	m_iInstructionsRun = 0;
+	m_oHalt = HaltState::None;
+	m_iIdleLoopLength = 0;
+	m_iIdleLoopTarget = 0;
+	m_iIdleLoopCooldown = 0;
+	m_iIdleLoopFailures = 0;
+	m_iFrameStartCycle = 0;
+	m_iFrameActiveCycles = 0;
+	m_bFrameIdled = false;
+	m_iGovernorPeak = 0;
+	m_iGovernorFrames = 0;
 	m_iCurrentOpcode = 0;
 
-	Display::KeyDisplayAccess oKeyDisplay;
-	Display::Reset( oKeyDisplay );
+	m_oFrameBuffer.Reset();
 
-	for( auto it = m_aMemory.begin(); it != m_aMemory.end(); ++it )
-		it->clear();
-	m_aMirorMemory.fill( DecodedOpcode{} );
+	std::fill( std::begin( m_aRegisters ),std::end( m_aRegisters ),Data< uint8_t >() );
+	std::fill( std::begin( m_aStack ),std::end( m_aStack ),Data< uint16_t >() );
+	std::fill( std::begin( m_aFlags ),std::end( m_aFlags ),Data< uint8_t >() );
 
-	memset( m_aRegisters,0,sizeof( m_aRegisters ) );
-	memset( m_aStack,0,sizeof( m_aStack ) );
-	memset( m_aFlags,0,sizeof( m_aFlags ) );
+	memset( m_aKeys,0,sizeof( m_aKeys ) );
+	m_iCountBeforeStop = 0;
 
-	m_pSoundManagerInstance->OnReset();
+	m_oAudio = AudioRegisters();
 	m_bXoCHIP = false;
-
-	Chip8::KeyAccess oKey;
-	Init( oKey,m_sCurrentRomLoaded );
 }
 
-void Chip8::_LoadFont()
+//Guest memory and settings from m_pRom, the bytes and the database infos are already in there
+void Chip8::_ApplyRomImage()
 {
-	for( uint8_t i = 0; i < 80; ++i )
-	{
-		m_aMemory[ START_FONT_MEMORY_ADDRESS + i ] = m_aFontset[ i ];
-	}
+	if( m_pRom->bXoChip )
+		SetIfCurrentRomXoChip( true );
 
-	for( uint8_t i = 0; i < 160; ++i )
+	//Mapped, not copied : machines running the same image share its pages until they write them
+	if( m_pRom->pBytes != nullptr )
 	{
-		m_aMemory[ START_sFONT_MEMORY_ADDRESS + i ] = m_aSuperFontset[ i ];
+		const size_t iFirstPage = START_ROM_MEMORY_ADDRESS >> MEMORY_PAGE_SHIFT;
+		for( size_t i = 0; i < m_pRom->pBytes->size() >> MEMORY_PAGE_SHIFT; ++i )
+			m_aPages[ iFirstPage + i ] = m_pRom->pBytes->data() + ( i << MEMORY_PAGE_SHIFT );
+		_MirrorGuardPages();
 	}
+	m_oFrameBuffer.SetResolution( m_pRom->oSettings.iWidth,m_pRom->oSettings.iHeight );
+	if( m_pRom->oSettings.iTickrate != 0 )
+		m_iInstructionsPerFrame = m_iMaxInstructionsPerFrame = m_pRom->oSettings.iTickrate;
+#ifndef OVERRIDE_DATABASE_QUIRKS
+	if( m_pRom->oSettings.bHasQuirks )
+		m_oCurrentQuirk = m_pRom->oSettings.oQuirk;
+#endif
+	_SelectQuirkSpecialization();
+	m_pAotModule = AotRuntime::FindModule( m_pRom->oSettings.sHash );
+}
+
+//Cleared address space of iSize bytes with the fonts in place, the caches follow its size
+//Private pages go back unmapped to the machine, nothing is freed
+void Chip8::_AllocateMemory( const uint32_t iSize )
+{
+	m_aPages.assign( ( iSize >> MEMORY_PAGE_SHIFT ) + MEMORY_GUARD_PAGES,s_aZeroPage.data() );
+	for( size_t i = 0; i < START_ROM_MEMORY_ADDRESS >> MEMORY_PAGE_SHIFT; ++i )
+		m_aPages[ i ] = s_aInterpreterArea.data() + ( i << MEMORY_PAGE_SHIFT );
+	m_aSharedPages.assign( iSize >> MEMORY_PAGE_SHIFT,true );
+	m_iPrivatePagesUsed = 0;
+	m_aDecodeCache.assign( iSize,PredecodedOpcode{} );
+	m_aTranslatedCode.assign( iSize,false );
+	m_iAddressMask = static_cast< uint16_t >( iSize - 1 );
+	_MirrorGuardPages();
+}
+
+//Same but keeps what is already mapped, for a ROM found to be XO-CHIP after it has been loaded
+void Chip8::_GrowMemory( const uint32_t iSize )
+{
+	m_aPages.resize( GetMemorySize() >> MEMORY_PAGE_SHIFT ); //Drops the old guard pages, what follows is zero
+	m_aPages.resize( ( iSize >> MEMORY_PAGE_SHIFT ) + MEMORY_GUARD_PAGES,s_aZeroPage.data() );
+	m_aSharedPages.resize( iSize >> MEMORY_PAGE_SHIFT,true );
+	m_aDecodeCache.resize( iSize );
+	m_aTranslatedCode.resize( iSize,false );
+	m_iAddressMask = static_cast< uint16_t >( iSize - 1 );
+	_MirrorGuardPages();
+}
+
+void Chip8::SetIfCurrentRomXoChip( bool bXoChip )
+{
+	m_bXoCHIP = bXoChip;
+	if( bXoChip && GetMemorySize() < XOCHIP_MEMORY_SIZE )
+		_GrowMemory( XOCHIP_MEMORY_SIZE );
+}
+
+Chip8::InterpreterArea Chip8::_BuildInterpreterArea()
+{
+	InterpreterArea aArea = {};
+	std::copy( std::begin( s_aFontset ),std::end( s_aFontset ),aArea.begin() + START_FONT_MEMORY_ADDRESS );
+	std::copy( std::begin( s_aSuperFontset ),std::end( s_aSuperFontset ),aArea.begin() + START_sFONT_MEMORY_ADDRESS );
+	return aArea;
+}
+
+//First store into a shared page, the machine gets its own copy and the others keep seeing the original
+void Chip8::_CopyPageOnWrite( const uint16_t iPage )
+{
+	if( m_iPrivatePagesUsed == m_aPrivatePages.size() )
+		m_aPrivatePages.push_back( std::make_unique< MemoryPage >() );
+
+	MemoryPage& aPage = *m_aPrivatePages[ m_iPrivatePagesUsed++ ];
+	std::copy( m_aPages[ iPage ],m_aPages[ iPage ] + MEMORY_PAGE_SIZE,aPage.begin() );
+	m_aPages[ iPage ] = aPage.data();
+	m_aSharedPages[ iPage ] = false;
+	if( iPage < MEMORY_GUARD_PAGES )
+		_MirrorGuardPages();
+}
+
+//Reads running past the end of the address space go on at its start, without masking each address
+void Chip8::_MirrorGuardPages()
+{
+	const size_t iPageCount = GetMemorySize() >> MEMORY_PAGE_SHIFT;
+	for( size_t i = 0; i < MEMORY_GUARD_PAGES; ++i )
+		m_aPages[ iPageCount + i ] = m_aPages[ i ];
+}
+
+void Chip8::CopyMemory( uint8_t* pDest ) const
+{
+	for( size_t i = 0; i < GetMemorySize() >> MEMORY_PAGE_SHIFT; ++i )
+		std::copy( m_aPages[ i ],m_aPages[ i ] + MEMORY_PAGE_SIZE,pDest + ( i << MEMORY_PAGE_SHIFT ) );
+}
+
+MachineFootprint Chip8::GetFootprint() const
+{
+	MachineFootprint oFootprint;
+	oFootprint.iObject = sizeof( Chip8 );
+	oFootprint.iMemory = m_aPrivatePages.size() * ( sizeof( MemoryPage ) + sizeof( void* ) ) + m_aPages.capacity() * sizeof( uint8_t* ) + ( m_aSharedPages.capacity() + 7 ) / 8;
+	oFootprint.iSharedMemory = m_pRom->pBytes != nullptr ? m_pRom->pBytes->size() : 0;
+	oFootprint.iDecodeCache = m_aDecodeCache.capacity() * sizeof( PredecodedOpcode );
+	oFootprint.iBlocks = ( m_aTranslatedCode.capacity() + 7 ) / 8 + m_aBlocks.bucket_count() * sizeof( void* );
+	for( const auto& oEntry : m_aBlocks )
+		oFootprint.iBlocks += sizeof( TranslatedBlock ) + oEntry.second->aOps.capacity() * sizeof( DecodedOpcode );
+	return oFootprint;
 }
 
 void Chip8::_LoadROM( const char* sROMToLoad )
 {
+	//A new image each load, the previous one may still be used by other machines. Its bytes stay null when nothing could be read
+	std::shared_ptr< RomImage > pRom = std::make_shared< RomImage >();
+	m_pRom = pRom;
 	if( sROMToLoad == nullptr )
 	{
 		m_oState = RunningState::Pause;
@@ -199,45 +361,42 @@ void Chip8::_LoadROM( const char* sROMToLoad )
 	if( file.is_open() )
 	{
 		std::streamsize size = file.tellg();
-		if( size <= 0 || size > MEMORY_SIZE - START_ROM_MEMORY_ADDRESS )
+		if( size <= 0 || size > XOCHIP_MEMORY_SIZE - START_ROM_MEMORY_ADDRESS )
 		{
 			throw std::runtime_error( "Size ROM invalid" );
 			return;
 		}
 
-		char* memblock = new char[ size ];
+		std::shared_ptr< std::vector< uint8_t > > pBytes = std::make_shared< std::vector< uint8_t > >( ( size + MEMORY_PAGE_SIZE - 1 ) & ~( MEMORY_PAGE_SIZE - 1 ),0 );
 		file.seekg( 0,std::ios::beg );
-		file.read( memblock,size );
+		file.read( reinterpret_cast< char* >( pBytes->data() ),size );
 		file.close();
 
 		std::streamsize bytesRead = file.gcount();
 		if( bytesRead != size )
 		{
 			throw std::runtime_error( "Size read not conform" );
-			delete[] memblock;
 			return;
 		}
-
-		for( uint16_t i = 0; i < bytesRead; ++i )
-		{
-			m_aMemory[ START_ROM_MEMORY_ADDRESS + i ] = static_cast< uint8_t >( memblock[ i ] );
-		}
+		pRom->pBytes = pBytes;
+		pRom->iSize = static_cast< uint32_t >( size );
 
 		Init_RomSettings oRomSettings;
-		oRomSettings.LookForDatabaseInfos( memblock,size );
+		oRomSettings.LookForDatabaseInfos( reinterpret_cast< const char* >( pBytes->data() ),size,pRom->oSettings );
+
+		//Only XO-CHIP gets the 64K, a ROM too big for 4K can't be anything else
+		const bool bXoChipPlatform = pRom->oSettings.iPlatform >= 0 && m_sSupportedPlatform[ pRom->oSettings.iPlatform ] == "xochip";
+		pRom->bXoChip = bXoChipPlatform || size > CHIP8_MEMORY_SIZE - START_ROM_MEMORY_ADDRESS;
+		_ApplyRomImage();
 
 #ifdef DEBUG_INFO
-		Disassembler::Disassemble_ROM( memblock,sROMToLoad,size );
+		m_oDisassembler.Disassemble_ROM( sROMToLoad,*this );
+		pRom->bXoChip = m_bXoCHIP; //XO-CHIP opcodes found by the walk
 #endif // DEBUG_INFO
 
-
-		delete[] memblock;
-
-		if( m_oState != RunningState::LoadNewRom )
-		{
-			KeyAccess oKey;
-			SetROMPathFileToLoad( oKey,sROMToLoad );
-		}
+		pRom->sPath = sROMToLoad;
+		if( m_oState != RunningState::LoadNewRom && m_sCurrentRomLoaded.c_str() != sROMToLoad )
+			m_sCurrentRomLoaded = sROMToLoad;
 	}
 	else
 	{
@@ -258,6 +417,14 @@ void Chip8::EmulateCycle( const KeyAccess& key )
 	if( m_oState == RunningState::Pause || m_oState == RunningState::Stop )
 		return;
 
+	//Quirks edited from the debugger : decoded handlers and compiled blocks were made for the previous ones
+	if( m_oCurrentQuirk != m_oSpecializedQuirk )
+	{
+		_SelectQuirkSpecialization();
+		_FlushDecodeCache();
+		_FlushBlockCache();
+	}
+
 	bool bForceNextStep = false;
 #ifdef DEBUG_INFO
 	if( m_oState == RunningState::StepNextFrame )
@@ -267,73 +434,279 @@ void Chip8::EmulateCycle( const KeyAccess& key )
 	}
 #endif
 
-	for( int i = 0; i < m_iInstructionsPerFrame; ++i )
+	//One guest frame : run up to the next event, fire what is due, until the vblank
+	//A step, a breakpoint or the end of the program leaves the frame unfinished, the next call picks it up on the same cycle
+	_FireDueEvents(); //Input sampled at the start of the frame
+	for( ;; )
 	{
-		_FetchDecode_Opcode();
+		//Looked at before the halt is run through, m_iCycle is still where the guest stopped
+		if( m_oHalt != HaltState::None && !m_bFrameIdled )
+		{
+			m_bFrameIdled = true;
+			m_iFrameActiveCycles = static_cast< uint32_t >( m_iCycle - m_iFrameStartCycle );
+		}
+
+		_RunUntil( m_oScheduler.GetNextCycle(),bForceNextStep );
+		if( _FireDueEvents() )
+		{
+			_GovernInstructionsPerFrame();
+			return;
+		}
+		if( m_oState != RunningState::Running )
+			return;
+	}
+}
+
+void Chip8::SetIpfGovernor( const bool bEnabled )
+{
+	m_bIpfGovernor = bEnabled;
+	m_iGovernorPeak = 0;
+	m_iGovernorFrames = 0;
+	if( !bEnabled && m_iInstructionsPerFrame != m_iMaxInstructionsPerFrame )
+	{
+		m_iInstructionsPerFrame = m_iMaxInstructionsPerFrame;
+		m_oScheduler.Reset( m_iCycle,m_iInstructionsPerFrame );
+	}
+}
+
+//At the vblank : doubled as soon as a frame runs to its end without idling, otherwise lowered to 1.5x the busiest frame of the window
+void Chip8::_GovernInstructionsPerFrame()
+{
+	const uint32_t iActive = m_bFrameIdled ? m_iFrameActiveCycles : static_cast< uint32_t >( m_iCycle - m_iFrameStartCycle );
+	const bool bSaturated = !m_bFrameIdled;
+	m_iFrameStartCycle = m_iCycle;
+	m_bFrameIdled = false;
+	if( !m_bIpfGovernor )
+		return;
+
+	int iIPF = m_iInstructionsPerFrame;
+	if( bSaturated )
+	{
+		iIPF = std::min( m_iMaxInstructionsPerFrame,iIPF * 2 );
+		m_iGovernorPeak = 0;
+		m_iGovernorFrames = 0;
+	}
+	else
+	{
+		m_iGovernorPeak = std::max( m_iGovernorPeak,iActive );
+		if( ++m_iGovernorFrames >= GOVERNOR_WINDOW_FRAMES )
+		{
+			const int iFloor = std::min( m_pRom->oSettings.iTickrate != 0 ? m_pRom->oSettings.iTickrate : GOVERNOR_MIN_IPF,m_iMaxInstructionsPerFrame );
+			const int iTarget = std::max( iFloor,static_cast< int >( m_iGovernorPeak + m_iGovernorPeak / 2 + 1 ) );
+			if( iTarget < iIPF )
+				iIPF = std::max( iTarget,iIPF / 2 );
+			m_iGovernorPeak = 0;
+			m_iGovernorFrames = 0;
+		}
+	}
+
+	//The next frame is the first one with the new length
+	if( iIPF != m_iInstructionsPerFrame )
+	{
+		m_iInstructionsPerFrame = iIPF;
+		m_oScheduler.Reset( m_iCycle,m_iInstructionsPerFrame );
+	}
+}
+
+void Chip8::_RunUntil( const uint64_t iCycle,const bool bForceNextStep )
+{
+	if( iCycle <= m_iCycle )
+		return;
+
+	//Only a step or a breakpoint of an attached debugger needs a look after every instruction, every other frame takes a plain loop
+	bool bInstrumented = false;
+#ifdef DEBUG_INFO
+	bInstrumented = bForceNextStep || ( m_bDebuggerAttached && m_iAdressBreakpoint != 0 );
+#endif
+
+	switch( m_oHalt )
+	{
+	case HaltState::None:
+		break;
+	case HaltState::IdleLoop:
+	{
+		//Whole iterations only, the loop is left on the instruction running them would have reached. A step or a breakpoint sees every one
+		m_oHalt = HaltState::None;
+		const uint64_t iSkipped = bInstrumented ? 0 : ( iCycle - m_iCycle ) / m_iIdleLoopLength * m_iIdleLoopLength;
+		if( iSkipped != 0 )
+		{
+			m_iCycle += iSkipped;
+			++m_oIdleLoopStats.iSkips;
+			m_oIdleLoopStats.iSkippedCycles += iSkipped;
+			if( iCycle <= m_iCycle )
+				return;
+		}
+		break;
+	}
+	default:
+		m_iCycle = iCycle; //Nothing to run until the event that wakes it up
+		return;
+	}
+	const uint32_t iBudget = static_cast< uint32_t >( iCycle - m_iCycle );
+	//Only the loops below run opcodes, whatever they moved the cycle clock by was executed
+	const uint64_t iFirstCycle = m_iCycle;
+
+#ifdef DEBUG_INFO
+	if( bInstrumented )
+		_RunInstrumented( bForceNextStep,iBudget );
+	else
+#endif
+	if( m_oEngine != ExecutionEngine::Interpreter )
+		_RunBlocks( iBudget );
+	else
+	{
+		switch( m_oDispatch )
+		{
+		case InterpreterDispatch::Switch:			_RunInterpreter< InterpreterDispatch::Switch >( iBudget ); break;
+		case InterpreterDispatch::PredecodeCache:	_RunInterpreter< InterpreterDispatch::PredecodeCache >( iBudget ); break;
+		case InterpreterDispatch::OpcodeTable:		_RunInterpreter< InterpreterDispatch::OpcodeTable >( iBudget ); break;
+		case InterpreterDispatch::Threaded:			( this->*m_pQuirkSpecialization->pRunThreaded )( iBudget ); break;
+		}
+	}
+	m_iInstructionsRun += m_iCycle - iFirstCycle;
+
+	//The end of the program only had to break the loop, the state says the rest
+	if( m_oHalt == HaltState::Ended )
+		m_oHalt = HaltState::None;
+}
+
+//Fires every event due at the current cycle, true once the vblank has been fired ( what is due after it waits for the next frame )
+bool Chip8::_FireDueEvents()
+{
+	for( ;; )
+	{
+		switch( m_oScheduler.PopDue( m_iCycle,m_iInstructionsPerFrame ) )
+		{
+		case GuestEvent::TimerTick:
+			_UpdateTimers();
+			break;
+		case GuestEvent::AudioUpdate:
+			m_oAudio.bBuzzer = m_iSound_timer > 0;
+			break;
+		case GuestEvent::VBlank:
+			if( m_oHalt == HaltState::WaitVBlank )
+				m_oHalt = HaltState::None;
+			return true;
+		case GuestEvent::InputSample:
+			//FX0A only looks at the keys, the same ones give the same answer
+			if( m_oHalt == HaltState::WaitKey && memcmp( m_aKeys,m_aHostKeys,sizeof( m_aKeys ) ) != 0 )
+				m_oHalt = HaltState::None;
+			memcpy( m_aKeys,m_aHostKeys,sizeof( m_aKeys ) );
+			break;
+		default:
+			return false;
+		}
+	}
+}
+
+//Fetch and dispatch, nothing else : the debugger never stops this loop, the end of the program comes as a halt from JMP or 00FD
+template< InterpreterDispatch oDispatch >
+void Chip8::_RunInterpreter( const uint32_t iBudget )
+{
+	for( uint32_t i = 0; i < iBudget; ++i )
+	{
+		_FetchDecode< oDispatch >();
 		++m_iCycle;
 
+		if( m_oHalt != HaltState::None )
+			break;
+	}
+}
+
 #ifdef DEBUG_INFO
-		if( m_oState == RunningState::Stop || _IsEndReached() || bForceNextStep )
+//Checked after every instruction, whatever the engine : stepping and breakpoints have to stop on the exact opcode
+void Chip8::_RunInstrumented( const bool bForceNextStep,const uint32_t iBudget )
+{
+	for( uint32_t i = 0; i < iBudget; ++i )
+	{
+		_FetchDecode_Opcode();
+		++m_iCycle;
+
+		if( m_oHalt != HaltState::None || bForceNextStep )
 			break;
 
-		if( m_iPC == m_iAdressBreakpoint )
+		if( m_bDebuggerAttached && m_iPC == m_iAdressBreakpoint )
 		{
 			m_oState = RunningState::Pause;
 			m_iAdressBreakpoint = 0;
 			break;
 		}
-#else
-		if ( _IsEndReached() )
-			break;
-#endif
 	}
-	_UpdateTimers();
-	m_pSoundManagerInstance->Manage( m_iSound_timer );
 }
+#endif
 
-void Chip8::AskForState( const KeyAccess& key,RunningState oState ) const
+void Chip8::AskForState( const KeyAccess& key,RunningState oState )
 {
 	m_oState = oState;
 }
 
-void Chip8::DestroyCpu()
+void Chip8::_FetchDecode_Opcode()
 {
-	delete[] m_sCurrentRomLoaded;
-	delete m_pSingleton;
+	switch( m_oDispatch )
+	{
+	case InterpreterDispatch::PredecodeCache:	_FetchDecode< InterpreterDispatch::PredecodeCache >(); break;
+	case InterpreterDispatch::OpcodeTable:
+	case InterpreterDispatch::Threaded:			_FetchDecode< InterpreterDispatch::OpcodeTable >(); break; //Threaded code is single stepped through the table
+	default:									_FetchDecode< InterpreterDispatch::Switch >(); break;
+	}
 }
 
-void Chip8::_FetchDecode_Opcode()
+template< InterpreterDispatch oDispatch >
+inline void Chip8::_FetchDecode()
 {
 #ifdef OVERFLOW_CONTROL
-	m_iI &= 0xFFF;
-	m_iPC &= 0xFFF;
-	m_iCurrentOpcode = m_aMemory[ m_iPC ] << 8 | m_aMemory[ ( m_iPC + 1 ) & 0xFFF ];
-#else
-	m_iCurrentOpcode = m_aMemory[ m_iPC ] << 8 | m_aMemory[ m_iPC + 1 ];
+	m_iI &= m_iAddressMask;
+	m_iPC &= m_iAddressMask;
 #endif
-	
-#ifndef USE_SWITCH_BRANCH
-	uint16_t iStartPC = m_iPC;
-	m_iPC += 2;
 
-	m_pCurrentOpcode = &m_aMirorMemory[ iStartPC ];
-	if( m_pCurrentOpcode->fct != nullptr )
-		( this->*m_pCurrentOpcode->fct )( ); //Opcode known, just trigger the call
-	else
+	if constexpr( oDispatch == InterpreterDispatch::PredecodeCache )
 	{
-		m_pCurrentOpcode->NNN = m_iCurrentOpcode & 0x0FFF;
+		PredecodedOpcode& oDecoded = m_aDecodeCache[ m_iPC & m_iAddressMask ];
+		if( oDecoded.iHandler != NOT_DECODED )
+			++m_oDecodeCacheStats.iHits;
+		else
+		{
+			++m_oDecodeCacheStats.iMisses;
+			oDecoded.iOpcode = _ReadOpcode( m_iPC );
+			oDecoded.iHandler = s_aHandlerIds[ oDecoded.iOpcode ];
+		}
 
-		m_pCurrentOpcode->X = ( m_iCurrentOpcode & 0x0F00 ) >> 8;
-		m_pCurrentOpcode->Y = ( m_iCurrentOpcode & 0x00F0 ) >> 4;
-		m_pCurrentOpcode->NN = m_iCurrentOpcode & 0x00FF;
-		m_pCurrentOpcode->N = m_iCurrentOpcode & 0x000F;
+		m_iCurrentOpcode = oDecoded.iOpcode;
+		m_iPC += 2;
+		( this->*m_pQuirkSpecialization->pExecuteHandler )( oDecoded.iHandler );
+	}
 
-		uint8_t iIndex = ( m_iCurrentOpcode & 0xF000 ) >> 12;
-		CheckOpcodeAndExec( iIndex,m_aMainTable );
+	else if constexpr( oDispatch == InterpreterDispatch::OpcodeTable )
+	{
+		m_iCurrentOpcode = _ReadOpcode( m_iPC );
+		m_iPC += 2;
+		( this->*_DecodeOpcode( m_iCurrentOpcode ) )( );
 	}
-#else
-	m_iPC += 2;
+	else
+	{
+		m_iCurrentOpcode = _ReadOpcode( m_iPC );
+		m_iPC += 2;
+		( this->*m_pQuirkSpecialization->pExecuteSwitch )( );
+	}
+}
+
+//Predecoded entries only keep the handler id, a flat switch on it inlines the handlers instead of calling them through the table
+template< size_t iQuirks >
+void Chip8::_ExecuteHandler( const uint8_t iHandler )
+{
+#define HANDLER_CASE( NAME ) case Handler_##NAME: NAME(); break;
+#define QUIRK_HANDLER_CASE( NAME ) case Handler_##NAME: NAME< iQuirks >(); break;
+	switch( iHandler )
+	{
+		CHIP8_OPCODE_HANDLERS( HANDLER_CASE,QUIRK_HANDLER_CASE )
+	}
+#undef QUIRK_HANDLER_CASE
+#undef HANDLER_CASE
+}
 
+template< size_t iQuirks >
+void Chip8::_ExecuteSwitch()
+{
 	//Serve only as comparaison
 	uint16_t opcodeNibble = m_iCurrentOpcode & 0xF000;
 	switch( opcodeNibble )
@@ -342,17 +715,17 @@ void Chip8::_FetchDecode_Opcode()
 	{
 		uint16_t check = m_iCurrentOpcode & 0x00FF;
 		if( GetY() == 0x0C )
-			SCROLL_DOWN();
+			SCROLL_DOWN< iQuirks >();
 		else if( GetY() == 0x0D )
-			SCROLL_UP();
+			SCROLL_UP< iQuirks >();
 		else if( check == 0xE0 )
 			CLS();
 		else if( check == 0xEE )
 			RET();
 		else if( check == 0xFB )
-			SCROLL_RIGHT();
+			SCROLL_RIGHT< iQuirks >();
 		else if( check == 0xFC )
-			SCROLL_LEFT();
+			SCROLL_LEFT< iQuirks >();
 		else if( check == 0xFD )
 			QUIT();
 		else if( check == 0xFE )
@@ -408,13 +781,13 @@ void Chip8::_FetchDecode_Opcode()
 			LD_VX_VY();
 			break;
 		case 1:
-			OR();
+			OR< iQuirks >();
 			break;
 		case 2:
-			AND();
+			AND< iQuirks >();
 			break;
 		case 3:
-			XOR();
+			XOR< iQuirks >();
 			break;
 		case 4:
 			ADD_VX_VY();
@@ -423,187 +796,843 @@ void Chip8::_FetchDecode_Opcode()
 			SUB_VX_VY();
 			break;
 		case 6:
-			SHR();
+			SHR< iQuirks >();
 			break;
 		case 7:
 			SUBN_VX_VY();
 			break;
 		case 0xE:
-			SHL();
+			SHL< iQuirks >();
 			break;
 		default:
 			std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
 			break;
 		}
 	}
-	break;
-	case 0x9000:
-		SNE_VX_VY();
-		break;
-	case 0xA000:
-		LD_I_NNN();
-		break;
-	case 0xB000:
-		JMP_NNN();
-		break;
-	case 0xC000:
-		RND();
-		break;
-	case 0xD000:
-		DRAW();
-		break;
-	case 0xE000:
+	break;
+	case 0x9000:
+		SNE_VX_VY();
+		break;
+	case 0xA000:
+		LD_I_NNN();
+		break;
+	case 0xB000:
+		JMP_NNN< iQuirks >();
+		break;
+	case 0xC000:
+		RND();
+		break;
+	case 0xD000:
+		DRAW< iQuirks >();
+		break;
+	case 0xE000:
+	{
+		uint16_t check = m_iCurrentOpcode & 0x00FF;
+		if( check == 0x9E )
+			SKP();
+		else if( check == 0xA1 )
+			SKNP();
+		else
+			std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
+	}
+	break;
+	case 0xF000:
+	{
+		switch( m_iCurrentOpcode & 0xF0FF )
+		{
+			case 0xF000:
+				LD_I_NNNN();
+			break;
+			case 0xF001:
+				PLANE();
+				break;
+			case 0xF002:
+				AUDIO();
+				break;
+			case 0xF007:
+				LD_VX_DT();
+				break;
+			case 0xF00A:
+				LD_VX_KEY();
+				break;
+			case 0xF015:
+				LD_DT_VX();
+				break;
+			case 0xF018:
+				LD_ST_VX();
+				break;
+			case 0xF01E:
+				ADD_I_VX();
+				break;
+			case 0xF029:
+				LD_I_FONT();
+				break;
+			case 0xF030:
+				LD_I_SUPER_FONT();
+				break;
+			case 0xF033:
+				BCD();
+				break;
+			case 0xF03A:
+				AUDIO_PITCH();
+				break;
+			case 0xF055:
+				LD_I_VX< iQuirks >();
+				break;
+			case 0xF065:
+				LD_VX_I< iQuirks >();
+				break;
+			case 0xF075:
+				SAVEFLAGS_VX();
+				break;
+			case 0xF085:
+				LOADFLAGS_VX();
+				break;
+			default:
+				std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
+				break;
+		}
+	}
+	break;
+	default:
+		std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
+		break;
+	}
+}
+
+uint8_t Chip8::IsAnyKeyPress() const
+{
+	for( int i = 0; i < 16; ++i )
+	{
+		if( m_aKeys[ i ] )
+			return i;
+	}
+
+	return 0xFF;
+}
+
+void Chip8::_UpdateTimers()
+{
+	if( m_iDelay_timer > 0 )
+		--m_iDelay_timer;
+
+	if( m_iSound_timer > 0 )
+		--m_iSound_timer;
+}
+
+//Right after a 1NNN, PC on its target : a JMP on itself never leaves and ends the program once run again JMPCHECK_BEFORE_ENDING times, any other one may start an idle loop
+void Chip8::_CheckJump( const uint16_t iJumpAddress )
+{
+	if( m_iPC != iJumpAddress )
+	{
+		m_iCountBeforeStop = 0;
+		_CheckIdleLoop();
+		return;
+	}
+
+	if( m_iCountBeforeStop <= JMPCHECK_BEFORE_ENDING )
+		++m_iCountBeforeStop;
+	if( m_iCountBeforeStop > JMPCHECK_BEFORE_ENDING )
+	{
+		m_oState = RunningState::Pause;
+		m_oHalt = HaltState::Ended;
+	}
+}
+
+//Right after a JMP, PC on its target : if one more iteration from here leaves the registers as they are, every next one does the same until DT or the keys change
+void Chip8::_CheckIdleLoop()
+{
+	const uint16_t iTarget = m_iPC;
+	if( iTarget == m_iIdleLoopTarget && m_iIdleLoopCooldown > 0 )
+	{
+		--m_iIdleLoopCooldown;
+		return;
+	}
+	if( iTarget != m_iIdleLoopTarget )
+	{
+		m_iIdleLoopTarget = iTarget;
+		m_iIdleLoopFailures = 0;
+	}
+
+	const std::vector< uint16_t >& aHacks = m_pRom->oSettings.aIdleLoops;
+	const bool bKnownLoop = std::find( aHacks.begin(),aHacks.end(),iTarget ) != aHacks.end();
+	uint32_t iLength = 0;
+	if( _SimulateIdleLoop( iTarget,bKnownLoop ? IDLE_LOOP_MAX_HACK_INSTRUCTIONS : IDLE_LOOP_MAX_INSTRUCTIONS,iLength ) )
+	{
+		m_iIdleLoopFailures = 0;
+		m_iIdleLoopLength = iLength;
+		m_oHalt = HaltState::IdleLoop;
+		return;
+	}
+
+	if( m_iIdleLoopFailures < IDLE_LOOP_MAX_FAILURES )
+		++m_iIdleLoopFailures;
+	m_iIdleLoopCooldown = ( 1 << m_iIdleLoopFailures ) - 1;
+}
+
+//Runs one iteration on a copy of the registers, only with opcodes that read DT, keys or registers and write registers.
+//True when it comes back to iTarget through a JMP with the registers unchanged, iLength is then the iteration in instructions
+bool Chip8::_SimulateIdleLoop( const uint16_t iTarget,const uint32_t iMaxInstructions,uint32_t& iLength ) const
+{
+	uint8_t V[ 16 ];
+	for( int i = 0; i < 16; ++i )
+		V[ i ] = m_aRegisters[ i ];
+
+	uint16_t iPC = iTarget;
+	for( iLength = 1; iLength <= iMaxInstructions; ++iLength )
+	{
+		const uint16_t iOpcode = _ReadOpcode( iPC );
+		iPC += 2;
+		const uint8_t X = ( iOpcode & 0x0F00 ) >> 8;
+		const uint8_t Y = ( iOpcode & 0x00F0 ) >> 4;
+		const uint8_t NN = iOpcode & 0x00FF;
+		bool bSkip = false;
+		switch( iOpcode & 0xF000 )
+		{
+		case 0x1000:
+			if( ( iOpcode & 0x0FFF ) != iTarget || iLength == 1 ) //A JMP on itself is the end of the program, left to _CheckJump
+				return false;
+			for( int i = 0; i < 16; ++i )
+			{
+				if( V[ i ] != m_aRegisters[ i ] )
+					return false;
+			}
+			return true;
+		case 0x3000: bSkip = V[ X ] == NN; break;
+		case 0x4000: bSkip = V[ X ] != NN; break;
+		case 0x5000:
+			if( ( iOpcode & 0x000F ) != 0 )
+				return false;
+			bSkip = V[ X ] == V[ Y ];
+			break;
+		case 0x9000:
+			if( ( iOpcode & 0x000F ) != 0 )
+				return false;
+			bSkip = V[ X ] != V[ Y ];
+			break;
+		case 0x6000: V[ X ] = NN; break;
+		case 0x7000: V[ X ] += NN; break;
+		case 0x8000:
+			if( ( iOpcode & 0x000F ) != 0 )
+				return false;
+			V[ X ] = V[ Y ];
+			break;
+		case 0xE000:
+			if( NN == 0x9E )
+				bSkip = GetKeyState( V[ X ] ) != 0;
+			else if( NN == 0xA1 )
+				bSkip = GetKeyState( V[ X ] ) == 0;
+			else
+				return false;
+			break;
+		case 0xF000:
+			if( NN != 0x07 )
+				return false;
+			V[ X ] = m_iDelay_timer;
+			break;
+		default:
+			return false;
+		}
+
+		//Same as SkipNextBlock
+		if( bSkip )
+			iPC += _ReadOpcode( iPC ) == 0xF000 ? 4 : 2;
+	}
+	return false;
+}
+
+//Same decoding as the switch in _FetchDecode_Opcode, but returns the handler id so tables can be built from it
+constexpr uint8_t Chip8::_DecodeHandlerId( const uint16_t iOpcode )
+{
+	switch( iOpcode & 0xF000 )
+	{
+	case 0x0000:
+	{
+		uint16_t check = iOpcode & 0x00FF;
+		if( ( ( iOpcode & 0x00F0 ) >> 4 ) == 0x0C )
+			return Handler_SCROLL_DOWN;
+		else if( ( ( iOpcode & 0x00F0 ) >> 4 ) == 0x0D )
+			return Handler_SCROLL_UP;
+		else if( check == 0xE0 )
+			return Handler_CLS;
+		else if( check == 0xEE )
+			return Handler_RET;
+		else if( check == 0xFB )
+			return Handler_SCROLL_RIGHT;
+		else if( check == 0xFC )
+			return Handler_SCROLL_LEFT;
+		else if( check == 0xFD )
+			return Handler_QUIT;
+		else if( check == 0xFE )
+			return Handler_LORES;
+		else if( check == 0xFF )
+			return Handler_HIRES;
+	}
+	break;
+	case 0x1000: return Handler_JMP;
+	case 0x2000: return Handler_CALL;
+	case 0x3000: return Handler_SE_VX_NN;
+	case 0x4000: return Handler_SNE_VX_NN;
+	case 0x5000:
+	{
+		switch( iOpcode & 0x000F )
+		{
+			case 0: return Handler_SE_VX_VY;
+			case 2: return Handler_SAVE_RANGE;
+			case 3: return Handler_LOAD_RANGE;
+		}
+	}
+	break;
+	case 0x6000: return Handler_LD_VX_NN;
+	case 0x7000: return Handler_ADD_VX_NN;
+	case 0x8000:
+	{
+		switch( iOpcode & 0x000F )
+		{
+			case 0: return Handler_LD_VX_VY;
+			case 1: return Handler_OR;
+			case 2: return Handler_AND;
+			case 3: return Handler_XOR;
+			case 4: return Handler_ADD_VX_VY;
+			case 5: return Handler_SUB_VX_VY;
+			case 6: return Handler_SHR;
+			case 7: return Handler_SUBN_VX_VY;
+			case 0xE: return Handler_SHL;
+		}
+	}
+	break;
+	case 0x9000: return Handler_SNE_VX_VY;
+	case 0xA000: return Handler_LD_I_NNN;
+	case 0xB000: return Handler_JMP_NNN;
+	case 0xC000: return Handler_RND;
+	case 0xD000: return Handler_DRAW;
+	case 0xE000:
+	{
+		uint16_t check = iOpcode & 0x00FF;
+		if( check == 0x9E )
+			return Handler_SKP;
+		else if( check == 0xA1 )
+			return Handler_SKNP;
+	}
+	break;
+	case 0xF000:
+	{
+		switch( iOpcode & 0xF0FF )
+		{
+			case 0xF000: return Handler_LD_I_NNNN;
+			case 0xF001: return Handler_PLANE;
+			case 0xF002: return Handler_AUDIO;
+			case 0xF007: return Handler_LD_VX_DT;
+			case 0xF00A: return Handler_LD_VX_KEY;
+			case 0xF015: return Handler_LD_DT_VX;
+			case 0xF018: return Handler_LD_ST_VX;
+			case 0xF01E: return Handler_ADD_I_VX;
+			case 0xF029: return Handler_LD_I_FONT;
+			case 0xF030: return Handler_LD_I_SUPER_FONT;
+			case 0xF033: return Handler_BCD;
+			case 0xF03A: return Handler_AUDIO_PITCH;
+			case 0xF055: return Handler_LD_I_VX;
+			case 0xF065: return Handler_LD_VX_I;
+			case 0xF075: return Handler_SAVEFLAGS_VX;
+			case 0xF085: return Handler_LOADFLAGS_VX;
+		}
+	}
+	break;
+	}
+
+	return Handler_UNKNOWN_OPCODE;
+}
+
+constexpr std::array< uint8_t,0x10000 > Chip8::_BuildHandlerIdTable()
+{
+	std::array< uint8_t,0x10000 > aTable{};
+	for( uint32_t iOpcode = 0; iOpcode < 0x10000; ++iOpcode )
+		aTable[ iOpcode ] = _DecodeHandlerId( static_cast< uint16_t >( iOpcode ) );
+	return aTable;
+}
+
+template< size_t iQuirks >
+constexpr auto Chip8::_BuildQuirkSpecialization() -> QuirkSpecialization
+{
+	static_assert( Handler_Count == OPCODE_HANDLER_COUNT );
+
+#define HANDLER_ADDRESS( NAME ) &Chip8::NAME,
+#define QUIRK_HANDLER_ADDRESS( NAME ) &Chip8::NAME< iQuirks >,
+	return QuirkSpecialization{ { CHIP8_OPCODE_HANDLERS( HANDLER_ADDRESS,QUIRK_HANDLER_ADDRESS ) },&Chip8::_ExecuteSwitch< iQuirks >,&Chip8::_ExecuteHandler< iQuirks >,&Chip8::_RunThreaded< iQuirks > };
+#undef QUIRK_HANDLER_ADDRESS
+#undef HANDLER_ADDRESS
+}
+
+template< size_t... aQuirks >
+constexpr auto Chip8::_BuildQuirkSpecializations( std::index_sequence< aQuirks... > ) -> std::array< QuirkSpecialization,QUIRK_SPECIALIZATIONS >
+{
+	return { _BuildQuirkSpecialization< aQuirks >()... };
+}
+
+//Both filled by the compiler, nothing is decoded at startup
+constinit const std::array< uint8_t,0x10000 > Chip8::s_aHandlerIds = Chip8::_BuildHandlerIdTable();
+constinit const std::array< Chip8::QuirkSpecialization,Chip8::QUIRK_SPECIALIZATIONS > Chip8::s_aQuirkSpecializations = Chip8::_BuildQuirkSpecializations( std::make_index_sequence< QUIRK_SPECIALIZATIONS >() );
+
+//The platform picked by the database first, then any platform with the same quirks, the generic code otherwise
+void Chip8::_SelectQuirkSpecialization()
+{
+	static_assert( PLATFORM_QUIRKS.size() == std::tuple_size_v< decltype( m_sSupportedPlatform ) > );
+
+	size_t iSpecialization = GENERIC_QUIRKS;
+	if( m_pRom->oSettings.iPlatform >= 0 && PLATFORM_QUIRKS[ m_pRom->oSettings.iPlatform ] == m_oCurrentQuirk )
+		iSpecialization = m_pRom->oSettings.iPlatform;
+	else
+	{
+		for( size_t i = 0; i < PLATFORM_QUIRKS.size(); ++i )
+		{
+			if( PLATFORM_QUIRKS[ i ] == m_oCurrentQuirk )
+			{
+				iSpecialization = i;
+				break;
+			}
+		}
+	}
+
+	m_pQuirkSpecialization = &s_aQuirkSpecializations[ iSpecialization ];
+	m_oSpecializedQuirk = m_oCurrentQuirk;
+}
+
+//Every guest store goes through here so the decoded opcodes covering that byte can be dropped
+inline void Chip8::_WriteMemory( const uint16_t iGuestAddr,const uint8_t iValue )
+{
+	const uint16_t iAddr = iGuestAddr & m_iAddressMask;
+	const uint16_t iPage = iAddr >> MEMORY_PAGE_SHIFT;
+	if( m_aPages[ iPage ][ iAddr & ( MEMORY_PAGE_SIZE - 1 ) ] == iValue ) //Storing the same byte again ( common in XO-CHIP patching loops ) keeps the decoded code valid and the page shared
+		return;
+
+	if( m_aSharedPages[ iPage ] )
+		_CopyPageOnWrite( iPage );
+	m_aPages[ iPage ][ iAddr & ( MEMORY_PAGE_SIZE - 1 ) ] = iValue;
+	_InvalidateCode( iAddr,1 );
+}
+
+//Register file stores : one compare and one copy per page touched, the caches are told once per changed run of bytes
+void Chip8::_WriteMemoryBlock( const uint16_t iGuestAddr,const uint8_t* pSrc,const uint32_t iSize )
+{
+	uint16_t iAddr = iGuestAddr & m_iAddressMask;
+	for( uint32_t iDone = 0; iDone < iSize; )
+	{
+		const uint16_t iPage = iAddr >> MEMORY_PAGE_SHIFT;
+		const uint32_t iOffset = iAddr & ( MEMORY_PAGE_SIZE - 1 );
+		const uint32_t iCount = std::min( iSize - iDone,MEMORY_PAGE_SIZE - iOffset );
+		if( memcmp( m_aPages[ iPage ] + iOffset,pSrc + iDone,iCount ) != 0 )
+		{
+			if( m_aSharedPages[ iPage ] )
+				_CopyPageOnWrite( iPage );
+			memcpy( m_aPages[ iPage ] + iOffset,pSrc + iDone,iCount );
+			_InvalidateCode( iAddr,iCount );
+		}
+		iDone += iCount;
+		iAddr = ( iAddr + iCount ) & m_iAddressMask;
+	}
+}
+
+void Chip8::ReadMemoryBlock( const uint16_t iAddr,uint8_t* pDest,const uint32_t iSize ) const
+{
+	const uint16_t iStart = iAddr & m_iAddressMask;
+	for( uint32_t iDone = 0; iDone < iSize; )
+	{
+		const uint32_t iCurrent = iStart + iDone; //May land in the guard pages, no need to mask it
+		const uint32_t iOffset = iCurrent & ( MEMORY_PAGE_SIZE - 1 );
+		const uint32_t iCount = std::min( iSize - iDone,MEMORY_PAGE_SIZE - iOffset );
+		memcpy( pDest + iDone,m_aPages[ iCurrent >> MEMORY_PAGE_SHIFT ] + iOffset,iCount );
+		iDone += iCount;
+	}
+}
+
+//iSize bytes from iAddr ( masked, not crossing the end ) changed : drop the blocks and the decoded opcodes reading them
+inline void Chip8::_InvalidateCode( const uint16_t iAddr,const uint32_t iSize )
+{
+	for( uint32_t i = iAddr; i < iAddr + iSize; ++i )
+	{
+		if( m_aTranslatedCode[ i ] ) //Cleared for the whole block once it is retired
+			_InvalidateBlocks( static_cast< uint16_t >( i ) );
+	}
+
+	if( m_oDispatch == InterpreterDispatch::PredecodeCache )
+	{
+		//A byte is either the high part of the opcode at its address or the low part of the one before
+		for( uint32_t i = 0; i <= iSize; ++i )
+		{
+			PredecodedOpcode& oDecoded = m_aDecodeCache[ ( iAddr + i - 1 ) & m_iAddressMask ];
+			if( oDecoded.iHandler != NOT_DECODED )
+			{
+				oDecoded.iHandler = NOT_DECODED;
+				++m_oDecodeCacheStats.iInvalidations;
+			}
+		}
+	}
+}
+
+void Chip8::_FlushDecodeCache()
+{
+	std::fill( m_aDecodeCache.begin(),m_aDecodeCache.end(),PredecodedOpcode{} );
+}
+
+void Chip8::SetExecutionEngine( ExecutionEngine oEngine )
+{
+	if( oEngine == ExecutionEngine::Jit && !JitCompiler::IsSupported() )
+	{
+		std::cerr << "ERROR::CHIP8::JIT_NOT_SUPPORTED_ON_THIS_HOST, using basic blocks" << std::endl;
+		oEngine = ExecutionEngine::BasicBlocks;
+	}
+
+	if( oEngine == ExecutionEngine::Jit && m_pJit == nullptr )
+		m_pJit = std::make_unique< JitCompiler >();
+
+	if( oEngine != m_oEngine )
+		_FlushBlockCache();
+
+	m_oEngine = oEngine;
+}
+
+void Chip8::_RunBlocks( const uint32_t iFrameBudget )
+{
+	m_aRetiredBlocks.clear();
+
+	int64_t iBudget = iFrameBudget;
+	TranslatedBlock* pBlock = nullptr;
+	while( iBudget > 0 )
+	{
+		//Follow the link left by the previous block, otherwise look it up and link it for the next time
+		TranslatedBlock* pNext = nullptr;
+		if( pBlock != nullptr )
+		{
+			if( pBlock->aSuccessors[ 0 ] != nullptr && pBlock->aSuccessorPC[ 0 ] == m_iPC )
+				pNext = pBlock->aSuccessors[ 0 ];
+			else if( pBlock->aSuccessors[ 1 ] != nullptr && pBlock->aSuccessorPC[ 1 ] == m_iPC )
+				pNext = pBlock->aSuccessors[ 1 ];
+		}
+
+		if( pNext != nullptr )
+			++m_oBlockCacheStats.iChainedRuns;
+		else
+		{
+			pNext = _FindOrTranslateBlock( m_iPC );
+			if( pBlock != nullptr && pBlock->bValid )
+			{
+				int iSlot = pBlock->aSuccessors[ 0 ] == nullptr ? 0 : 1;
+				pBlock->aSuccessorPC[ iSlot ] = m_iPC;
+				pBlock->aSuccessors[ iSlot ] = pNext;
+			}
+		}
+		pBlock = pNext;
+
+		const int iBlockLength = static_cast< int >( pBlock->aOps.size() );
+		if( iBlockLength == 0 || iBlockLength > iBudget )
+		{
+			//Not enough instructions left in this frame ( or PC at the very end of memory ), finish it one by one to stay on the exact same cycle
+			for( ; iBudget > 0; --iBudget )
+			{
+				_FetchDecode_Opcode();
+				++m_iCycle;
+				if( m_oHalt != HaltState::None )
+					return;
+			}
+			return;
+		}
+
+		if( pBlock->pNative != nullptr )
+			pBlock->pNative( this );
+		else
+		{
+			for( const DecodedOpcode& oOp : pBlock->aOps )
+			{
+				m_iCurrentOpcode = oOp.iOpcode;
+				m_iPC += 2;
+				( this->*oOp.fct )( );
+			}
+		}
+		m_iCycle += iBlockLength;
+		iBudget -= iBlockLength;
+		++m_oBlockCacheStats.iBlocksRun;
+
+		//Native code writes the target of the final JMP without its handler, the jump is looked at here
+		if( pBlock->pNative != nullptr && ( m_iCurrentOpcode & 0xF000 ) == 0x1000 )
+			_CheckJump( static_cast< uint16_t >( pBlock->iEndPC - 2 ) );
+
+		//FX0A, DXYN, 00FD and JMP end their block, a halt is always seen right after it
+		if( m_oHalt != HaltState::None )
+			break;
+	}
+}
+
+Chip8::TranslatedBlock* Chip8::_FindOrTranslateBlock( const uint16_t iStartPC )
+{
+	auto it = m_aBlocks.find( iStartPC );
+	if( it != m_aBlocks.end() )
+		return it->second.get();
+
+	std::unique_ptr< TranslatedBlock > pBlock = std::make_unique< TranslatedBlock >();
+	pBlock->iStartPC = iStartPC;
+
+	std::vector< uint16_t > aOpcodes;
+	uint16_t iFollowingOpcode = 0;
+	pBlock->iEndPC = _ScanBlock( *this,iStartPC,aOpcodes,iFollowingOpcode );
+	for( const uint16_t iOpcode : aOpcodes )
 	{
-		uint16_t check = m_iCurrentOpcode & 0x00FF;
-		if( check == 0x9E )
-			SKP();
-		else if( check == 0xA1 )
-			SKNP();
-		else
-			std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
+		DecodedOpcode oOp;
+		oOp.iOpcode = iOpcode;
+		oOp.fct = _DecodeOpcode( iOpcode );
+		pBlock->aOps.push_back( oOp );
 	}
-	break;
-	case 0xF000:
+
+	if( m_oEngine == ExecutionEngine::Aot && !aOpcodes.empty() )
 	{
-		switch( m_iCurrentOpcode & 0xF0FF )
+		pBlock->pNative = _FindAotBlock( iStartPC,aOpcodes,iFollowingOpcode );
+		if( pBlock->pNative != nullptr )
+			++m_oBlockCacheStats.iAotBlocks;
+	}
+	else if( m_oEngine == ExecutionEngine::Jit && !aOpcodes.empty() )
+	{
+		pBlock->pNative = m_pJit->Compile( aOpcodes,iStartPC,iFollowingOpcode,m_oCurrentQuirk,_GetJitLayout(),&Chip8::_JitExecuteOpcode );
+		if( pBlock->pNative == nullptr )
 		{
-			case 0xF000:
-				LD_I_NNNN();
-			break;
-			case 0xF001:
-				PLANE();
-				break;
-			case 0xF002:
-				AUDIO();
-				break;
-			case 0xF007:
-				LD_VX_DT();
-				break;
-			case 0xF00A:
-				LD_VX_KEY();
-				break;
-			case 0xF015:
-				LD_DT_VX();
-				break;
-			case 0xF018:
-				LD_ST_VX();
-				break;
-			case 0xF01E:
-				ADD_I_VX();
-				break;
-			case 0xF029:
-				LD_I_FONT();
-				break;
-			case 0xF030:
-				LD_I_SUPER_FONT();
-				break;
-			case 0xF033:
-				BCD();
-				break;
-			case 0xF03A:
-				AUDIO_PITCH();
-				break;
-			case 0xF055:
-				LD_I_VX();
-				break;
-			case 0xF065:
-				LD_VX_I();
-				break;
-			case 0xF075:
-				SAVEFLAGS_VX();
-				break;
-			case 0xF085:
-				LOADFLAGS_VX();
-				break;
-			default:
-				std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
-				break;
+			//Code buffer full : the whole cache is flushed, every block is translated again when next reached
+			_FlushBlockCache();
+			pBlock->pNative = m_pJit->Compile( aOpcodes,iStartPC,iFollowingOpcode,m_oCurrentQuirk,_GetJitLayout(),&Chip8::_JitExecuteOpcode );
 		}
 	}
-	break;
-	default:
-		std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
-		break;
+
+	for( uint32_t iAddr = pBlock->iStartPC; iAddr < pBlock->iEndPC; ++iAddr )
+		m_aTranslatedCode[ iAddr ] = true;
+
+	++m_oBlockCacheStats.iBlocksTranslated;
+	TranslatedBlock* pResult = pBlock.get();
+	m_aBlocks[ iStartPC ] = std::move( pBlock );
+	return pResult;
+}
+
+//Straight-line code from iStartPC up to the first terminator, returns the exclusive end of the bytes it depends on
+uint32_t Chip8::_ScanBlock( const Chip8& oCpu,const uint16_t iStartPC,std::vector< uint16_t >& aOpcodes,uint16_t& iFollowingOpcode )
+{
+	uint32_t iPC = iStartPC;
+	const uint32_t iMemorySize = oCpu.GetMemorySize();
+	while( aOpcodes.size() < MAX_BLOCK_LENGTH && iPC + 1 < iMemorySize )
+	{
+		const uint16_t iOpcode = oCpu._ReadOpcode( iPC );
+		aOpcodes.push_back( iOpcode );
+
+		iPC += iOpcode == 0xF000 ? 4 : 2; //LD I, NNNN reads its operand from the next word
+		if( _IsBlockTerminator( iOpcode ) )
+			break;
 	}
-#endif
+	//A final skip looks at the next opcode ( F000 is 4 bytes long ), it has to stay the same
+	iFollowingOpcode = 0;
+	if( !aOpcodes.empty() && _IsSkipOpcode( aOpcodes.back() ) && iPC + 1 < iMemorySize )
+	{
+		iFollowingOpcode = oCpu._ReadOpcode( iPC );
+		iPC += 2;
+	}
+	return std::min( iPC,iMemorySize );
 }
 
-void Chip8::_UpdateTimers()
+//The generated code is only trusted when the guest code is still the one it was compiled from, patched code stays interpreted
+JitCompiler::NativeBlock Chip8::_FindAotBlock( const uint16_t iStartPC,const std::vector< uint16_t >& aOpcodes,const uint16_t iFollowingOpcode ) const
 {
-	if( m_iDelay_timer > 0 )
-		--m_iDelay_timer;
+	if( m_pAotModule == nullptr || m_pAotModule->oQuirk != m_oCurrentQuirk )
+		return nullptr;
 
-	if( m_iSound_timer > 0 )
-		--m_iSound_timer;
+	const AotBlock* pAotBlock = AotRuntime::FindBlock( *m_pAotModule,iStartPC );
+	if( pAotBlock == nullptr || pAotBlock->iOpcodeCount != aOpcodes.size() || pAotBlock->iFollowingOpcode != iFollowingOpcode )
+		return nullptr;
+
+	if( !std::equal( aOpcodes.begin(),aOpcodes.end(),pAotBlock->aOpcodes ) )
+		return nullptr;
+
+	return pAotBlock->pFunction;
 }
 
-bool Chip8::_IsEndReached()
+void Chip8::_InvalidateBlocks( const uint16_t iAddr )
 {
-	if( m_iCurrentOpcode == m_iLastOpcode && ( m_iCurrentOpcode & 0xF000 ) == 0x1000 )
+	uint32_t iMinAddr = 0xFFFFFFFF;
+	uint32_t iMaxAddr = 0;
+	for( auto it = m_aBlocks.begin(); it != m_aBlocks.end(); )
 	{
-		++m_iCountBeforeStop;
-		if( m_iCountBeforeStop >= JMPCHECK_BEFORE_ENDING )
+		TranslatedBlock* pBlock = it->second.get();
+		if( iAddr >= pBlock->iStartPC && iAddr < pBlock->iEndPC )
 		{
-			m_oState = RunningState::Pause;
-			return true;
+			iMinAddr = std::min< uint32_t >( iMinAddr,pBlock->iStartPC );
+			iMaxAddr = std::max( iMaxAddr,pBlock->iEndPC );
+
+			pBlock->bValid = false;
+			pBlock->aSuccessors[ 0 ] = pBlock->aSuccessors[ 1 ] = nullptr;
+			m_aRetiredBlocks.push_back( std::move( it->second ) );
+			it = m_aBlocks.erase( it );
+			++m_oBlockCacheStats.iInvalidations;
 		}
+		else
+			++it;
 	}
-	else
+
+	for( uint32_t i = iMinAddr; i < iMaxAddr; ++i )
+		m_aTranslatedCode[ i ] = false;
+
+	//Drop the links to the retired blocks and give back the coverage still owned by the others
+	for( auto& oEntry : m_aBlocks )
 	{
-		m_iLastOpcode = m_iCurrentOpcode;
-		m_iCountBeforeStop = 0;
+		TranslatedBlock* pBlock = oEntry.second.get();
+		for( int iSlot = 0; iSlot < 2; ++iSlot )
+		{
+			if( pBlock->aSuccessors[ iSlot ] != nullptr && !pBlock->aSuccessors[ iSlot ]->bValid )
+				pBlock->aSuccessors[ iSlot ] = nullptr;
+		}
+
+		if( pBlock->iStartPC < iMaxAddr && pBlock->iEndPC > iMinAddr )
+		{
+			for( uint32_t i = std::max< uint32_t >( pBlock->iStartPC,iMinAddr ); i < std::min( pBlock->iEndPC,iMaxAddr ); ++i )
+				m_aTranslatedCode[ i ] = true;
+		}
 	}
+}
 
-	return false;
+void Chip8::_FlushBlockCache()
+{
+	//Blocks may still be referenced by a running frame, they are freed with the retired ones
+	for( auto& oEntry : m_aBlocks )
+	{
+		oEntry.second->bValid = false;
+		m_aRetiredBlocks.push_back( std::move( oEntry.second ) );
+	}
+	m_aBlocks.clear();
+	std::fill( m_aTranslatedCode.begin(),m_aTranslatedCode.end(),false );
+
+	if( m_pJit != nullptr )
+		m_pJit->Reset();
 }
 
-inline void Chip8::x0_Dispatch()
+bool Chip8::_IsSkipOpcode( const uint16_t iOpcode )
 {
-	uint8_t iLastNibble = m_iCurrentOpcode & 0x000F;
-	CheckOpcodeAndExec( iHexToIndex[ iLastNibble ],m_a0xF_Table );
+	switch( iOpcode & 0xF000 )
+	{
+	case 0x3000:
+	case 0x4000:
+	case 0x9000:
+	case 0xE000: return true;
+	case 0x5000: return ( iOpcode & 0x000F ) == 0;
+	default: return false;
+	}
 }
 
-inline void Chip8::x8_Dispatch()
+//Called from the native code for everything it doesn't emit itself, PC is on the opcode
+void Chip8::_JitExecuteOpcode( Chip8* pCpu,uint32_t iOpcode )
 {
-	uint8_t iLastNibble = m_iCurrentOpcode & 0x000F;
-	CheckOpcodeAndExec( iLastNibble,m_a0x8_Table );
+	pCpu->m_iCurrentOpcode = static_cast< uint16_t >( iOpcode );
+	pCpu->m_iPC += 2;
+	( pCpu->*pCpu->_DecodeOpcode( pCpu->m_iCurrentOpcode ) )( );
 }
 
-inline void Chip8::xE_Dispatch()
+JitCompiler::GuestLayout Chip8::_GetJitLayout() const
 {
-	uint8_t iThirdNibble = ( m_iCurrentOpcode & 0x00F0 ) >> 4;
-	CheckOpcodeAndExec( iThirdNibble,m_a0x8_Table );
+	//Data<T> only holds its value, the native code reads and writes it in place
+	auto Offset = [ this ]( const void* pMember ) { return static_cast< int32_t >( static_cast< const uint8_t* >( pMember ) - reinterpret_cast< const uint8_t* >( this ) ); };
+
+	JitCompiler::GuestLayout oLayout;
+	oLayout.iRegisters = Offset( &m_aRegisters[ 0 ] );
+	oLayout.iRegisterStride = sizeof( m_aRegisters[ 0 ] );
+	oLayout.iI = Offset( &m_iI );
+	oLayout.iPC = Offset( &m_iPC );
+	oLayout.iDelayTimer = Offset( &m_iDelay_timer );
+	oLayout.iSoundTimer = Offset( &m_iSound_timer );
+	oLayout.iCurrentOpcode = Offset( &m_iCurrentOpcode );
+	return oLayout;
 }
 
-inline void Chip8::xF_Dispatch()
+bool Chip8::_IsBlockTerminator( const uint16_t iOpcode )
 {
-	uint16_t iLastNibbles = m_iCurrentOpcode & 0x00FF;
-	if( iLastNibbles < 0x66 )
-		CheckOpcodeAndExec( iHexToIndex[ iLastNibbles ],m_a0xF_Table );
-#ifdef DEBUG_INFO
-	else
-		std::cerr << "Nibble > to HexToIndex array size" << std::endl;
-#endif
+	switch( iOpcode & 0xF000 )
+	{
+	case 0x0000: return ( iOpcode & 0x00FF ) == 0xEE || ( iOpcode & 0x00FF ) == 0xFD;	//RET, EXIT
+	case 0x1000:																		//JMP
+	case 0x2000:																		//CALL
+	case 0x3000:																		//SE VX, NN
+	case 0x4000:																		//SNE VX, NN
+	case 0x9000:																		//SNE VX, VY
+	case 0xB000:																		//JMP V0, NNN
+	case 0xD000:																		//DRW
+	case 0xE000: return true;															//SKP, SKNP
+	case 0x5000: return ( iOpcode & 0x000F ) != 3;										//SE VX, VY and SAVE range store
+	case 0xF000:
+	{
+		uint16_t iLastNibbles = iOpcode & 0x00FF;
+		return iLastNibbles == 0x0A || iLastNibbles == 0x33 || iLastNibbles == 0x55;		//Key wait, BCD and register stores
+	}
+	default: return false;
+	}
 }
 
-template< typename T,size_t N >
-inline void Chip8::CheckOpcodeAndExec( const T iNibble,const std::array<fct_opcode,N>& aTable )
+bool Chip8::IsDispatchSupported( [[maybe_unused]] const InterpreterDispatch oDispatch )
 {
-#ifdef DEBUG_INFO
-	if( aTable[ iNibble ] == nullptr || iNibble < 0 || iNibble >= aTable.size() )
-		std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
-	else
+#ifndef COMPUTED_GOTO_SUPPORTED
+	if( oDispatch == InterpreterDispatch::Threaded )
+		return false;
 #endif
+	return true;
+}
+
+void Chip8::SetInterpreterDispatch( InterpreterDispatch oDispatch )
+{
+	if( !IsDispatchSupported( oDispatch ) )
 	{
-		( this->*aTable[ iNibble ] )( );
-		m_pCurrentOpcode->fct = aTable[ iNibble ];
+		std::cerr << "ERROR::CHIP8::DISPATCH_NOT_SUPPORTED_BY_THIS_COMPILER, using the opcode table" << std::endl;
+		oDispatch = InterpreterDispatch::OpcodeTable;
 	}
+
+	//Writes are not tracked while the cache is off, start from scratch
+	if( oDispatch != m_oDispatch )
+		_FlushDecodeCache();
+
+	m_oDispatch = oDispatch;
+}
+
+//Runs the whole frame budget, each handler fetches the next opcode and jumps straight to its label
+template< size_t iQuirks >
+void Chip8::_RunThreaded( const uint32_t iFrameBudget )
+{
+#ifdef COMPUTED_GOTO_SUPPORTED
+#define THREADED_LABEL_ADDRESS( NAME ) &&Threaded_##NAME,
+	static void* const s_aLabels[] = { CHIP8_OPCODE_HANDLERS( THREADED_LABEL_ADDRESS,THREADED_LABEL_ADDRESS ) };
+#undef THREADED_LABEL_ADDRESS
+
+	int64_t iBudget = iFrameBudget;
+
+#define THREADED_DISPATCH() \
+	if( iBudget-- <= 0 ) \
+		return; \
+	m_iCurrentOpcode = _ReadOpcode( m_iPC ); \
+	m_iPC += 2; \
+	goto *s_aLabels[ s_aHandlerIds[ m_iCurrentOpcode ] ];
+
+#define THREADED_END_CHECK() if( m_oHalt != HaltState::None ) return;
+
+#define THREADED_HANDLER( NAME,CALL ) \
+	Threaded_##NAME: \
+	CALL(); \
+	++m_iCycle; \
+	THREADED_END_CHECK() \
+	THREADED_DISPATCH()
+#define THREADED_PLAIN_HANDLER( NAME ) THREADED_HANDLER( NAME,NAME )
+#define THREADED_QUIRK_HANDLER( NAME ) THREADED_HANDLER( NAME,NAME< iQuirks > )
+
+	THREADED_DISPATCH()
+	CHIP8_OPCODE_HANDLERS( THREADED_PLAIN_HANDLER,THREADED_QUIRK_HANDLER )
+
+#undef THREADED_QUIRK_HANDLER
+#undef THREADED_PLAIN_HANDLER
+#undef THREADED_HANDLER
+#undef THREADED_END_CHECK
+#undef THREADED_DISPATCH
+#endif
 }
 
 inline void Chip8::CLS()
 {
-	Display::KeyDisplayAccess oKeyDisplay;
-	Display::ClearScreen( oKeyDisplay );
+	m_oFrameBuffer.ClearScreen();
 }
 
 inline void Chip8::RET()
@@ -625,13 +1654,16 @@ inline void Chip8::RET()
 inline void Chip8::JMP()
 {
 	//Jumps to address NNN
+	const uint16_t iJumpAddress = m_iPC - 2;
 	m_iPC = GetNNN();
+	_CheckJump( iJumpAddress );
 }
 
+template< size_t iQuirks >
 inline void Chip8::JMP_NNN()
 {	
 	//Jumps to the address NNN plus V0
-	if( !Chip8::m_oCurrentQuirk.bQuirkJumpingFlag )
+	if( !_GetQuirks< iQuirks >().bQuirkJumpingFlag )
 		m_iPC = GetNNN() + m_aRegisters[ 0 ];
 	else
 		m_iPC = GetNNN() + m_aRegisters[ GetX() ];
@@ -697,12 +1729,7 @@ inline void Chip8::LD_VX_VY()
 
 inline void Chip8::LD_I_NNNN()
 {
-#ifdef OVERFLOW_CONTROL
-	m_iPC &= 0xFFF;
-	m_iI = m_aMemory[ m_iPC ] << 8 | m_aMemory[ ( m_iPC + 1 ) & 0xFFF ];
-#else
-	m_iI = m_aMemory[ m_iPC ] << 8 | m_aMemory[ m_iPC + 1 ];
-#endif
+	m_iI = _ReadOpcode( m_iPC );
 
 	m_iPC += 2;
 }
@@ -728,21 +1755,18 @@ inline void Chip8::LD_DT_VX()
 inline void Chip8::LD_VX_KEY()
 {
 	//A key press is awaited, and then stored in VX (blocking operation, all instruction halted until next key event, delay and sound timers should continue processing)
-	if( m_pInputInstance )
+	if( m_iPreviousKeyPressed != 0xFF && GetKeyState( m_iPreviousKeyPressed ) == 0 )//Previous Input has been released
 	{
-		if( m_iPreviousKeyPressed != 0xFF && m_pInputInstance->GetKeyState( m_iPreviousKeyPressed ) == 0 )//Previous Input has been released
-		{
-			m_aRegisters[ GetX() ] = m_iPreviousKeyPressed;
-			m_iPreviousKeyPressed = 0xFF;
-		}
-		else
-		{
-			m_iPreviousKeyPressed = m_pInputInstance->IsAnyKeyPress();
-			m_iPC -= 2;
-		}
+		m_aRegisters[ GetX() ] = m_iPreviousKeyPressed;
+		m_iPreviousKeyPressed = 0xFF;
 	}
 	else
+	{
+		//Executed again once the keys change, nothing is fetched until then
+		m_iPreviousKeyPressed = IsAnyKeyPress();
 		m_iPC -= 2;
+		m_oHalt = HaltState::WaitKey;
+	}
 }
 
 inline void Chip8::LD_ST_VX()
@@ -763,62 +1787,38 @@ inline void Chip8::LD_I_SUPER_FONT()
 	m_iI = START_sFONT_MEMORY_ADDRESS + ( ( m_aRegisters[ GetX() ] & 0xF ) * 10 );
 }
 
+template< size_t iQuirks >
 inline void Chip8::LD_I_VX()
 {
-	uint16_t iOriginal_I = m_iI;
 	//Stores from V0 to VX (including VX) in memory, starting at address I. The offset from I is increased by 1 for each value written, but I itself is left unmodified
-	for( int i = 0; i <= GetX(); ++i )
+	const uint8_t iCount = GetX() + 1;
+	_WriteMemoryBlock( m_iI,reinterpret_cast< const uint8_t* >( m_aRegisters ),iCount );
+
+	if( !_GetQuirks< iQuirks >().bMemoryIncrementByX && !_GetQuirks< iQuirks >().bMemoryUnchanged )
 	{
-		if( !Chip8::m_oCurrentQuirk.bMemoryIncrementByX )
-		{
-			m_aMemory[ m_iI ] = m_aRegisters[ i ];
-#ifdef OVERFLOW_CONTROL
-			m_iI = ( m_iI + 1 ) & 0xFFF;
-#else // OVERFLOW_CONTROL
-			++m_iI;
-#endif
-		}
-		else
-		{
 #ifdef OVERFLOW_CONTROL
-			m_aMemory[ ( m_iI + i ) & 0xFFF ] = m_aRegisters[ i ];
+		m_iI = ( m_iI + iCount ) & m_iAddressMask;
 #else // OVERFLOW_CONTROL
-			m_aMemory[ m_iI + i ] = m_aRegisters[ i ];
+		m_iI += iCount;
 #endif
-		}
 	}
-
-	if( Chip8::m_oCurrentQuirk.bMemoryUnchanged )
-		m_iI = iOriginal_I;
 }
 
+template< size_t iQuirks >
 inline void Chip8::LD_VX_I()
 {
-	uint16_t iOriginal_I = m_iI;
 	//Fills from V0 to VX (including VX) with values from memory, starting at address I. The offset from I is increased by 1 for each value read, but I itself is left unmodified
-	for( int i = 0; i <= GetX(); ++i )
+	const uint8_t iCount = GetX() + 1;
+	ReadMemoryBlock( m_iI,reinterpret_cast< uint8_t* >( m_aRegisters ),iCount );
+
+	if( !_GetQuirks< iQuirks >().bMemoryIncrementByX && !_GetQuirks< iQuirks >().bMemoryUnchanged )
 	{
-		if( !Chip8::m_oCurrentQuirk.bMemoryIncrementByX )
-		{
-			m_aRegisters[ i ] = m_aMemory[ m_iI ];
 #ifdef OVERFLOW_CONTROL
-			m_iI = ( m_iI + 1 ) & 0xFFF;
-#else
-			++m_iI;
-#endif
-		}
-		else
-		{
-#ifdef OVERFLOW_CONTROL
-			m_aRegisters[ i ] = m_aMemory[ ( m_iI + i ) & 0xFFF ];
-#else
-			m_aRegisters[ i ] = m_aMemory[ m_iI + i ];
+		m_iI = ( m_iI + iCount ) & m_iAddressMask;
+#else // OVERFLOW_CONTROL
+		m_iI += iCount;
 #endif
-		}
 	}
-
-	if( Chip8::m_oCurrentQuirk.bMemoryUnchanged )
-		m_iI = iOriginal_I;
 }
 
 inline void Chip8::SAVEFLAGS_VX()
@@ -841,75 +1841,79 @@ inline void Chip8::LOADFLAGS_VX()
 
 inline void Chip8::SAVE_RANGE()
 {
-	int k = 0;
-	uint8_t iX = GetX();
-	uint8_t iY = GetY();
+	const uint8_t iX = GetX();
+	const uint8_t iY = GetY();
 
-	int iStep = 1;
-	if( m_bXoCHIP && iX > iY )
-			iStep = -1;
+	//VX first, down to VY when X > Y
+	if( iX <= iY )
+	{
+		_WriteMemoryBlock( m_iI,reinterpret_cast< const uint8_t* >( m_aRegisters + iX ),iY - iX + 1 );
+		return;
+	}
 
-	for( int i = iX; i != iY + iStep; i += iStep, ++k )
-		m_aMemory[ GetI() + k ] = m_aRegisters[ i ];
+	uint8_t aReversed[ 16 ];
+	for( int k = 0; k <= iX - iY; ++k )
+		aReversed[ k ] = m_aRegisters[ iX - k ];
+	_WriteMemoryBlock( m_iI,aReversed,iX - iY + 1 );
 }
 
 inline void Chip8::LOAD_RANGE()
 {
-	int k = 0;
-	uint8_t iX = GetX();
-	uint8_t iY = GetY();
+	const uint8_t iX = GetX();
+	const uint8_t iY = GetY();
 
-	int iStep = 1;
-	if( m_bXoCHIP && iX > iY )
-		iStep = -1;
+	if( iX <= iY )
+	{
+		ReadMemoryBlock( m_iI,reinterpret_cast< uint8_t* >( m_aRegisters + iX ),iY - iX + 1 );
+		return;
+	}
 
-	for( int i = iX; i != iY + iStep; i += iStep,++k )
-		m_aRegisters[ i ] = m_aMemory[ GetI() + k ];
+	uint8_t aReversed[ 16 ];
+	ReadMemoryBlock( m_iI,aReversed,iX - iY + 1 );
+	for( int k = 0; k <= iX - iY; ++k )
+		m_aRegisters[ iX - k ] = aReversed[ k ];
 }
 
 inline void Chip8::HIRES()
 {
-	m_pDisplayInstance->SetResolutionMode( ResolutionMode::HIRES );
-
-	Display::KeyDisplayAccess oKeyDisplay;
-	Display::ClearScreen( oKeyDisplay, true );
+	m_oFrameBuffer.SetResolutionMode( ResolutionMode::HIRES );
+	m_oFrameBuffer.ClearScreen( true );
 }
 
 inline void Chip8::LORES()
 {
-	m_pDisplayInstance->SetResolutionMode( ResolutionMode::LORES );
-
-	Display::KeyDisplayAccess oKeyDisplay;
-	Display::ClearScreen( oKeyDisplay, true);
+	m_oFrameBuffer.SetResolutionMode( ResolutionMode::LORES );
+	m_oFrameBuffer.ClearScreen( true );
 }
 
+template< size_t iQuirks >
 inline void Chip8::SCROLL_DOWN()
 {
-	Display::KeyDisplayAccess oKeyDisplay;
-	Display::ScrollVertical( oKeyDisplay,GetN(), true );
+	m_oFrameBuffer.ScrollVertical( GetN(),true,_GetQuirks< iQuirks >().bLegacySrolling );
 }
 
+template< size_t iQuirks >
 inline void Chip8::SCROLL_UP()
 {
-	Display::KeyDisplayAccess oKeyDisplay;
-	Display::ScrollVertical( oKeyDisplay,GetN(), false );
+	m_oFrameBuffer.ScrollVertical( GetN(),false,_GetQuirks< iQuirks >().bLegacySrolling );
 }
 
+template< size_t iQuirks >
 inline void Chip8::SCROLL_LEFT()
 {
-	Display::KeyDisplayAccess oKeyDisplay;
-	Display::ScrollHorizontal( oKeyDisplay,true );
+	m_oFrameBuffer.ScrollHorizontal( true,_GetQuirks< iQuirks >().bLegacySrolling );
 }
 
+template< size_t iQuirks >
 inline void Chip8::SCROLL_RIGHT()
 {
-	Display::KeyDisplayAccess oKeyDisplay;
-	Display::ScrollHorizontal( oKeyDisplay,false );
+	m_oFrameBuffer.ScrollHorizontal( false,_GetQuirks< iQuirks >().bLegacySrolling );
 }
 
 inline void Chip8::QUIT()
 {
 	m_oState = RunningState::Stop;
+	m_oHalt = HaltState::Ended;
 }
 
 inline void Chip8::ADD_VX_NN()
@@ -945,6 +1949,7 @@ inline void Chip8::SUB_VX_VY()
 	// VF is set to 0 when there's an underflow, and 1 when there is not. (i.e. VF set to 1 if VX >= VY and 0 if not)
 }
 
+template< size_t iQuirks >
 inline void Chip8::SHR()
 {
 	uint8_t X = GetX();
@@ -952,7 +1957,7 @@ inline void Chip8::SHR()
 	//If the least - significant bit of Vx is 1, then VF is set to 1, otherwise 0. Then Vx is divided by 2.
 	uint8_t LSB = 0;
 
-	if( !Chip8::m_oCurrentQuirk.bShiftingFlag )
+	if( !_GetQuirks< iQuirks >().bShiftingFlag )
 	{
 		uint8_t Y = GetY();
 		LSB = ( m_aRegisters[ Y ] & 0x01 );
@@ -983,10 +1988,11 @@ inline void Chip8::SUBN_VX_VY()
 	// VF is set to 0 when there's an underflow, and 1 when there is not. (i.e. VF set to 1 if VY >= VX).
 }
 
+template< size_t iQuirks >
 inline void Chip8::SHL()
 {
 	uint8_t MSB = 0;
-	if( !Chip8::m_oCurrentQuirk.bShiftingFlag )
+	if( !_GetQuirks< iQuirks >().bShiftingFlag )
 	{
 		uint8_t Y = GetY();
 		// If the most-significant bit of Vy is 1.
@@ -1010,35 +2016,14 @@ inline void Chip8::SHL()
 inline void Chip8::RND()
 {
 	//Sets VX to the result of a bitwise and operation on a random number (Typically: 0 to 255) and NN
-	std::uniform_int_distribution<std::mt19937::result_type> dist( 0,255 );
-	m_aRegisters[ GetX() ] = dist( m_iRng ) & GetNN();
+	if( m_iRandomIndex == RANDOM_BATCH_SIZE )
+		_RefillRandomBytes();
+	m_aRegisters[ GetX() ] = m_aRandomBytes[ m_iRandomIndex++ ] & GetNN();
 }
 
+template< size_t iQuirks >
 inline void Chip8::DRAW()
 {
-	if( Chip8::m_oCurrentQuirk.bDispWaitFlag )
-	{
-		/*if( !Chip8::m_oCurrentQuirk.bLegacySrolling || ( Chip8::m_oCurrentQuirk.bLegacySrolling && m_pDisplayInstance->GetResolutionMode() == ResolutionMode::LORES ) )
-		{
-			//VBlank, waiting for next frame
-			if( m_iTimeLastFrame.time_since_epoch().count() == 0 )
-			{
-				m_iTimeLastFrame = m_iLastTimeUpdate;
-				m_iPC -= 2;
-				return;
-			}
-			if( m_iLastTimeUpdate >= ( m_iTimeLastFrame + Display::GetRefreshTick() ) )
-			{
-				m_iTimeLastFrame = {};
-			}
-			else
-			{
-				m_iPC -= 2;
-				return;
-			}
-		}*/
-	}
-
 	/*Display n-byte sprite starting at memory location I at (Vx, Vy), set VF = collision.
 	The interpreter reads N bytes from memory, starting at the address stored in I.
 	These bytes are then displayed as sprites on screen at coordinates (Vx, Vy). Sprites are XORed onto the existing screen.
@@ -1046,106 +2031,87 @@ inline void Chip8::DRAW()
 	If the sprite is positioned so part of it is outside the coordinates of the display, it wraps around to the opposite side of the screen
 	I value does not change after the execution of this instruction*/
 
-	Display::KeyDisplayAccess oKeyDisplay;
-
 	uint8_t iVFFlag = 0;
-	Display::DrawPixelAtPos( oKeyDisplay,m_aRegisters[ GetX() ],m_aRegisters[ GetY() ],GetN(),iVFFlag,Chip8::m_oCurrentQuirk.bWrapFlag );
+	if( _GetQuirks< iQuirks >().bWrapFlag )
+		m_oFrameBuffer.DrawPixelAtPos< true >( *this,m_aRegisters[ GetX() ],m_aRegisters[ GetY() ],GetN(),iVFFlag );
+	else
+		m_oFrameBuffer.DrawPixelAtPos< false >( *this,m_aRegisters[ GetX() ],m_aRegisters[ GetY() ],GetN(),iVFFlag );
 	m_aRegisters[ 15 ] = iVFFlag;
+
+	//VBlank : one sprite per frame, the rest of the frame is skipped ( legacy superchip only waits in lores )
+	if( _GetQuirks< iQuirks >().bDispWaitFlag )
+	{
+		if( !_GetQuirks< iQuirks >().bLegacySrolling || m_oFrameBuffer.GetResolutionMode() == ResolutionMode::LORES )
+			m_oHalt = HaltState::WaitVBlank;
+	}
 }
 
 inline void Chip8::SKP()
 {
 	//Skips the next instruction if the key stored in VX(only consider the lowest nibble) is pressed (usually the next instruction is a jump to skip a code block).
-	if( m_pInputInstance->GetKeyState( m_aRegisters[ GetX() ] ) )
+	if( GetKeyState( m_aRegisters[ GetX() ] ) )
 		SkipNextBlock();
 }
 
 inline void Chip8::SKNP()
 {
 	//Skips the next instruction if the key stored in VX(only consider the lowest nibble) is not pressed (usually the next instruction is a jump to skip a code block).
-	if( !m_pInputInstance->GetKeyState( m_aRegisters[ GetX() ] ) )
+	if( !GetKeyState( m_aRegisters[ GetX() ] ) )
 		SkipNextBlock();
 }
 
 inline void Chip8::PLANE()
 {
-	Display::GetInstance()->SetPlaneBitmask( GetX() );
+	m_oFrameBuffer.SetPlaneBitmask( GetX() );
 }
 
 inline void Chip8::AUDIO()
 {
-	uint8_t aSoundBuffer[ 16 ];
-	std::transform(
-		m_aMemory.begin() + m_iI,
-		m_aMemory.begin() + m_iI + 16,
-		aSoundBuffer,
-		[]( const Data<uint8_t>& data ) {
-			return data;
-		}
-	);
+	ReadMemoryBlock( m_iI,m_oAudio.aPattern,sizeof( m_oAudio.aPattern ) );
+
+	m_oAudio.bNewPattern = true;
+}
 
-	m_pSoundManagerInstance->LoadPatternInSoundBuffer( aSoundBuffer );
+inline void Chip8::UNKNOWN_OPCODE()
+{
+	std::cerr << "ERROR::OPCODE_UNKNOWN_" << std::hex << m_iCurrentOpcode << std::endl;
 }
 
 inline void Chip8::AUDIO_PITCH()
 {
-	m_pSoundManagerInstance->CalculateAndSetNewPitch( m_aRegisters[ GetX() ]);
+	m_oAudio.iPitch = m_aRegisters[ GetX() ];
+	m_oAudio.bNewPitch = true;
 }
 
 inline const uint8_t Chip8::GetX()
 {
-#ifndef USE_SWITCH_BRANCH
-	return m_pCurrentOpcode->X;
-#else
 	return ( m_iCurrentOpcode & 0x0F00 ) >> 8;
-#endif
 }
 
 inline const uint8_t Chip8::GetY()
 {
-#ifndef USE_SWITCH_BRANCH
-	return m_pCurrentOpcode->Y;
-#else
 	return ( m_iCurrentOpcode & 0x00F0 ) >> 4;
-#endif
 }
 
 inline const uint16_t Chip8::GetNNN()
 {
-#ifndef USE_SWITCH_BRANCH
-	return m_pCurrentOpcode->NNN;
-#else
 	return m_iCurrentOpcode & 0x0FFF;
-#endif
 }
 
 inline const uint8_t Chip8::GetNN()
 {
-#ifndef USE_SWITCH_BRANCH
-	return m_pCurrentOpcode->NN;
-#else
 	return  m_iCurrentOpcode & 0x00FF;
-#endif
 }
 
 inline const uint8_t Chip8::GetN()
 {
-#ifndef USE_SWITCH_BRANCH
-	return m_pCurrentOpcode->N;
-#else
 	return m_iCurrentOpcode & 0x000F;
-#endif
 }
 
 inline void Chip8::SkipNextBlock()
 {
 	uint16_t iNextOpcode = 0;
-#ifdef OVERFLOW_CONTROL
-	m_iPC &= 0xFFF;
-	iNextOpcode = m_aMemory[ m_iPC ] << 8 | m_aMemory[ ( m_iPC + 1 ) & 0xFFF ];
-#else
-	iNextOpcode = m_aMemory[ m_iPC ] << 8 | m_aMemory[ m_iPC + 1 ];
-#endif
+	iNextOpcode = _ReadOpcode( m_iPC );
 
 	if( iNextOpcode == 0xF000 )
 		m_iPC += 4;
@@ -1158,37 +2124,34 @@ inline void Chip8::BCD()
 	uint8_t X = GetX();
 
 	//Stores the binary-coded decimal representation of VX, with the hundreds digit in memory at location in I, the tens digit at location I+1, and the ones digit at location I+2
-#ifdef OVERFLOW_CONTROL
-	m_aMemory[ m_iI & 0xFFF ] = m_aRegisters[ X ] / 100;
-	m_aMemory[ ( m_iI + 1 ) & 0xFFF ] = ( m_aRegisters[ X ] / 10 ) % 10;
-	m_aMemory[ ( m_iI + 2 ) & 0xFFF ] = m_aRegisters[ X ] % 10;
-#else
-	m_aMemory[ m_iI ] = m_aRegisters[ X ] / 100;
-	m_aMemory[ m_iI + 1 ] = ( m_aRegisters[ X ] / 10 ) % 10;
-	m_aMemory[ m_iI + 2 ] = m_aRegisters[ X ] % 10;
-#endif
+	_WriteMemory( m_iI,m_aRegisters[ X ] / 100 );
+	_WriteMemory( m_iI + 1,( m_aRegisters[ X ] / 10 ) % 10 );
+	_WriteMemory( m_iI + 2,m_aRegisters[ X ] % 10 );
 }
 
+template< size_t iQuirks >
 inline void Chip8::OR()
 {
 	//Sets VX to VX or VY. (bitwise OR operation)
 	m_aRegisters[ GetX() ] |= m_aRegisters[ GetY() ];
-	if( Chip8::m_oCurrentQuirk.bVFResetFlag )
+	if( _GetQuirks< iQuirks >().bVFResetFlag )
 		m_aRegisters[ 15 ] = 0;
 }
 
+template< size_t iQuirks >
 inline void Chip8::AND()
 {
 	//Sets VX to VX and VY. (bitwise AND operation)
 	m_aRegisters[ GetX() ] &= m_aRegisters[ GetY() ];
-	if( Chip8::m_oCurrentQuirk.bVFResetFlag )
+	if( _GetQuirks< iQuirks >().bVFResetFlag )
 		m_aRegisters[ 15 ] = 0;
 }
 
+template< size_t iQuirks >
 inline void Chip8::XOR()
 {
 	//Sets VX to VX xor VY
 	m_aRegisters[ GetX() ] ^= m_aRegisters[ GetY() ];
-	if( Chip8::m_oCurrentQuirk.bVFResetFlag )
+	if( _GetQuirks< iQuirks >().bVFResetFlag )
 		m_aRegisters[ 15 ] = 0;
 }
\ No newline at end of file
@@ -1,12 +1,19 @@
 #pragma once
 
-#include <random>
 #include <deque>
 #include <chrono>
 #include <array>
-#include "SoundManager.h"
-#include "Input.h"
-#include "Display.h"
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include "FrameBuffer.h"
+#include "Init_RomSettings.h"
+#include "Disassembler.h"
+#include "JitCompiler.h"
+#include "EventScheduler.h"
 
 #ifdef LEAK_DETECTOR
 	#include <vld.h> //Here to avoid leak warnings on atig6pxx.dll when creating a window // wasapi on ma_device_init // window file explorer
@@ -24,7 +31,7 @@
 #endif
 
 
-//#define OVERFLOW_CONTROL for test purpose, will not work as is in xo chip
+//#define OVERFLOW_CONTROL for test purpose, keeps I and PC inside the address space and stops on a stack overflow
 
 enum class RunningState
 {
@@ -36,109 +43,159 @@ enum class RunningState
 	LoadNewRom
 };
 
+//The CPU stops fetching until the event that wakes it up, the timers keep running meanwhile
+enum class HaltState : uint8_t
+{
+	None,
+	WaitKey,	//FX0A, woken by the next InputSample that changes the keys
+	WaitVBlank,	//DXYN with the vblank quirk, woken by the end of the frame
+	IdleLoop,	//Polling loop that can't change anything before the next event, skipped by whole iterations
+	Ended		//JMP on itself or 00FD, the machine is paused or stopped already : only leaves the run loop, cleared right after
+};
+
 namespace MemoryMap
 {
 	constexpr uint16_t START_FONT_MEMORY_ADDRESS = 0x050;
 	constexpr uint16_t START_sFONT_MEMORY_ADDRESS = 0x0A0;
 	constexpr uint16_t START_ROM_MEMORY_ADDRESS = 0x200;
-	constexpr uint16_t MEMORY_SIZE = 0XFFFF;
+	constexpr uint32_t CHIP8_MEMORY_SIZE = 0x1000; //CHIP-8, SUPER-CHIP and their variants
+	constexpr uint32_t XOCHIP_MEMORY_SIZE = 0x10000;
+	constexpr uint16_t MEMORY_PAGE_SHIFT = 8; //Guest memory is mapped and copied on write by pages of 256 bytes
+	constexpr uint32_t MEMORY_PAGE_SIZE = 1 << MEMORY_PAGE_SHIFT;
+	constexpr uint32_t MEMORY_GUARD_PAGES = 1; //Mapped after the last page onto the first ones, an instruction reads at most 64 bytes from I
+	constexpr uint32_t MEMORY_GUARD_SIZE = MEMORY_GUARD_PAGES * MEMORY_PAGE_SIZE;
 }
 
-//#define OVERRIDE_DATABASE_QUIRKS //if def set values wanted below, otherwise there are erased by platforms specs quirks
-struct Quirk
+//XO-CHIP audio registers, the frontend consumes the dirty flags to refresh its own buffer
+struct AudioRegisters
+{
+	uint8_t aPattern[ 16 ] = { 0 };
+	uint8_t iPitch = 64;
+	bool bNewPattern = false;
+	bool bNewPitch = false;
+	bool bBuzzer = false; //Sound timer running, as of the last GuestEvent::AudioUpdate
+};
+
+//Predecode cache counters, an invalidation is only counted when a decoded entry gets dropped by a memory write
+struct DecodeCacheStats
+{
+	long long unsigned iHits = 0;
+	long long unsigned iMisses = 0;
+	long long unsigned iInvalidations = 0;
+};
+
+//How the interpreter goes from an opcode to its handler, all of them end up in the same handlers
+enum class InterpreterDispatch
+{
+	Switch,			//Nested switch on the opcode nibbles
+	PredecodeCache,	//Handler decoded once per address, dropped as soon as the guest writes over it
+	OpcodeTable,	//Constexpr table of handler ids indexed by the whole 16 bit opcode
+	Threaded		//Computed goto from a handler straight to the next one, GCC / Clang only
+};
+
+//How the guest code is run, every engine leaves the machine in the exact same state
+enum class ExecutionEngine
+{
+	Interpreter,	//One instruction at a time, optionally through the predecode cache
+	BasicBlocks,	//Straight-line blocks translated once and chained to their successors
+	Jit,			//Same blocks compiled to x86-64, falls back to BasicBlocks on other hosts
+	Aot				//Same blocks bound to the code Chip8_Recompiler generated for the ROM, interpreted when there is none
+};
+
+struct BlockCacheStats
 {
-	Quirk() {};
-	bool bVFResetFlag = true;
-	bool bMemoryUnchanged = false;
-	bool bMemoryIncrementByX = false;
-	bool bDispWaitFlag = true;
-	bool bWrapFlag = false;
-	bool bShiftingFlag = false;
-	bool bQuirkJumpingFlag = false;
-	bool bLegacySrolling = false; //Not a real quirk but serve if we want to simulate legacy superchip behavior - Need a manuel set
+	long long unsigned iBlocksTranslated = 0;
+	long long unsigned iBlocksRun = 0;
+	long long unsigned iChainedRuns = 0; //Successor found through the previous block link, no lookup
+	long long unsigned iInvalidations = 0;
+	long long unsigned iAotBlocks = 0; //Translated blocks bound to ahead-of-time compiled code
 };
 
+//Polling loops on DT or keys skipped up to the next event, an iteration is only skipped when it leaves the registers unchanged
+struct IdleLoopStats
+{
+	long long unsigned iSkips = 0;
+	long long unsigned iSkippedCycles = 0;
+};
+
+//Bytes owned by one machine, fonts and handler tables are shared and not counted
+struct MachineFootprint
+{
+	size_t iObject = 0; //sizeof( Chip8 ), registers, screen, quirks...
+	size_t iMemory = 0;
+	size_t iDecodeCache = 0;
+	size_t iBlocks = 0; //Translated blocks and their coverage, grows with the code run by the block engines
+	size_t iSharedMemory = 0; //ROM pages mapped from the image, paid once by every machine running it and not part of Total
+
+	size_t Total() const { return iObject + iMemory + iDecodeCache + iBlocks; }
+};
+
+//A ROM as read from disk with what the database and the disassembler found about it
+//Machines recycled by a MachinePool load it again without touching the disk, they all point to the same image
+struct RomImage
+{
+	std::string						sPath;
+	std::shared_ptr< std::vector< uint8_t > > pBytes; //Padded to whole pages, never written once loaded. Null when the last load failed
+	uint32_t						iSize = 0;
+	RomSettings						oSettings;
+	bool							bXoChip = false;
+};
+
+//Guest register or memory cell, a plain store : the debugger finds what changed by diffing the frames it displays
 template< typename T>
-struct alignas ( 4 ) Data
+struct Data
 {
 public:
-	Data() { oData = 0; m_bNewValue = false; m_bDirty = false; }
-
-	Data& operator=( const Data& rhs ) { return Update( [ & ] { oData = rhs.oData; } ); }
-	Data& operator=( const T& rhs ) { return Update( [ & ] { oData = rhs; } ); }
-	Data& operator+=( const T& rhs ) { return Update( [ & ] { oData += rhs; } ); }
-	Data& operator-=( const T& rhs ) { return Update( [ & ] { oData -= rhs; } ); }
-	Data& operator--() { return Update( [ & ] { --oData; } ); }
-	Data& operator++() { return Update( [ & ] { ++oData; } ); }
-	Data& operator|=( const T& rhs ) { return Update( [ & ] { oData |= rhs; } ); }
-	Data& operator&=( const T& rhs ) { return Update( [ & ] { oData &= rhs; } ); }
-	Data& operator^=( const T& rhs ) { return Update( [ & ] { oData ^= rhs; } ); }
-	Data& operator>>=( const T& rhs ) { return Update( [ & ] { oData >>= rhs; } ); }
-	Data& operator<<=( const T& rhs ) { return Update( [ & ] { oData <<= rhs; } ); }
+	Data() { oData = 0; }
+
+	Data& operator=( const T& rhs ) { oData = rhs; return *this; }
+	Data& operator+=( const T& rhs ) { oData += rhs; return *this; }
+	Data& operator-=( const T& rhs ) { oData -= rhs; return *this; }
+	Data& operator--() { --oData; return *this; }
+	Data& operator++() { ++oData; return *this; }
+	Data& operator|=( const T& rhs ) { oData |= rhs; return *this; }
+	Data& operator&=( const T& rhs ) { oData &= rhs; return *this; }
+	Data& operator^=( const T& rhs ) { oData ^= rhs; return *this; }
+	Data& operator>>=( const T& rhs ) { oData >>= rhs; return *this; }
+	Data& operator<<=( const T& rhs ) { oData <<= rhs; return *this; }
 
 	operator T() const { return oData; }
-	bool HasChanged() const { return m_bNewValue; }
-#ifdef DEBUG_INFO
-	void SetDataAsDirty() const
-	{
-		if( !m_bDirty )
-			m_bDirty = true;
-		else
-		{
-			m_bDirty = false;
-			m_bNewValue = false;
-		}
-	}
-#endif
 	bool IsNULL() const { return oData == 0; }
-	void clear() { oData = 0; m_bNewValue = false; }
+	void clear() { oData = 0; }
 
 private:
 	T oData;
-	mutable bool m_bNewValue;
-	mutable bool m_bDirty;
-	template< typename F>
-	Data& Update( F operation )
-	{
-#ifdef DEBUG_INFO
-		T previous = oData;
-#endif
-		operation();
-#ifdef DEBUG_INFO
-		m_bNewValue = ( previous != oData );
-		if( m_bNewValue )
-			m_bDirty = false;
-#endif
-		return *this;
-	}
 };
 
-class alignas( 16 ) Chip8
+struct AotModule;
+class alignas( 64 ) Chip8
 {
+	friend class AotRuntime;
 public:
 
 	class KeyAccess
 	{
 		friend class Chip8;
-		friend class Chip8_Debugger;
+		friend class EmulationThread;
 		friend int main( int argc,char** argv );
 		KeyAccess() {}
 	};
 
-	static Chip8* GetInstance()
-	{
-		if( m_pSingleton == nullptr )
-			m_pSingleton = new Chip8;
-		return m_pSingleton;
-	}
+	//Every machine owns its whole state ( memory, screen, quirks, timers, IPF ), as many as needed can live in the same process
+	Chip8();
+	~Chip8();
 
 	void							Init( const KeyAccess& oKey,const char* sROMToLoad );
+	void							Init( const KeyAccess& oKey,const std::shared_ptr< const RomImage >& pImage );
 	void							EmulateCycle( const KeyAccess& oKey );
-	void							AskForState( const KeyAccess& oKey,RunningState oState ) const;
-	void							DestroyCpu();
+	void							AskForState( const KeyAccess& oKey,RunningState oState );
 
-	const std::array<Data< uint8_t>,0xFFFF>* GetMemory() const { return &m_aMemory; }
-	Data<uint8_t> GetMemoryAtAddr( const uint16_t iAddr ) const { return m_aMemory[ iAddr ]; }
+	//Guest address space of the platform, addresses beyond it wrap
+	void							CopyMemory( uint8_t* pDest ) const; //GetMemorySize() bytes
+	uint32_t						GetMemorySize() const { return m_iAddressMask + 1u; }
+	uint8_t							GetMemoryAtAddr( const uint16_t iAddr ) const { return _ReadMemory( iAddr ); }
+	void							ReadMemoryBlock( const uint16_t iAddr,uint8_t* pDest,const uint32_t iSize ) const; //iSize up to MEMORY_GUARD_SIZE, wraps at the end
+	MachineFootprint				GetFootprint() const;
 
 	const Data< uint16_t>*			GetStack() const { return m_aStack; }
 	const Data< uint8_t>*			GetRegisters() const { return m_aRegisters; }
@@ -149,58 +206,148 @@ public:
 	const Data< uint8_t>			GetSP() const { return m_iSP; }
 	const Data< uint8_t>			GetDelayTimer() const { return m_iDelay_timer; }
 	const Data< uint8_t>			GetSoundTimer() const { return m_iSound_timer; }
-	long long unsigned				GetCycleId() const { return m_iCycle; }
+	long long unsigned				GetCycleId() const { return m_iCycle; } //Guest timeline, halts and idle loop skips move it without running anything
+	long long unsigned				GetInstructionsRun() const { return m_iInstructionsRun; } //Opcodes actually executed
 
 	bool							IsPause() const { return m_oState == RunningState::Pause; }
 	bool							IsStop() const { return m_oState == RunningState::Stop; }
 	bool							IsRunning() const { return m_oState == RunningState::Running; }
-#ifdef DEBUG_INFO
+	HaltState						GetHaltState() const { return m_oHalt; }
 	RunningState					GetState() const { return m_oState; }
+#ifdef DEBUG_INFO
 	uint16_t						GetBreakpointAdress() const { return m_iAdressBreakpoint; }
-	static void						SetBreakpoint( uint16_t iAdress ) { m_iAdressBreakpoint = iAdress; }
+	void							SetBreakpoint( uint16_t iAdress ) { m_iAdressBreakpoint = iAdress; }
+	//Breakpoints are only honoured while a debugger is attached, detached frames run the plain loops
+	void							AttachDebugger( [[maybe_unused]] const KeyAccess& oKey ) { m_bDebuggerAttached = true; }
+	void							DetachDebugger( [[maybe_unused]] const KeyAccess& oKey ) { m_bDebuggerAttached = false; }
+	bool							IsDebuggerAttached() const { return m_bDebuggerAttached; }
+	const Disassembler&				GetDisassembler() const { return m_oDisassembler; }
 #endif
 
-	static const int				GetInstructPerFrame() { return m_iInstructionsPerFrame; }
-	static void						SetInstructionPerFrame( const int iNewValue ) { m_iInstructionsPerFrame = iNewValue; }
+	int								GetInstructPerFrame() const { return m_iInstructionsPerFrame; }
+	void							SetInstructionPerFrame( const int iNewValue ) { m_iInstructionsPerFrame = m_iMaxInstructionsPerFrame = iNewValue; }
+	//Optional : IPF follows what the guest runs before it idles ( halts, idle loops ), between the database tickrate and the IPF set above
+	void							SetIpfGovernor( const bool bEnabled );
+	bool							IsIpfGovernorEnabled() const { return m_bIpfGovernor; }
+	int								GetMaxInstructPerFrame() const { return m_iMaxInstructionsPerFrame; }
 
-	const char*						GetCurrentRomLoaded() const { return m_sCurrentRomLoaded; }
+	const char*						GetCurrentRomLoaded() const { return m_sCurrentRomLoaded.empty() ? nullptr : m_sCurrentRomLoaded.c_str(); }
 	void							SetROMPathFileToLoad( const KeyAccess& oKey,const std::string& sSrc );
 
+	FrameBuffer&					GetFrameBuffer() { return m_oFrameBuffer; }
+	const FrameBuffer&				GetFrameBuffer() const { return m_oFrameBuffer; }
+	AudioRegisters&					GetAudioRegisters() { return m_oAudio; }
+	const RomSettings&				GetRomSettings() const { return m_pRom->oSettings; }
+	const std::shared_ptr< const RomImage >& GetRomImage() const { return m_pRom; }
+	uint32_t						GetLoadCount() const { return m_iLoadCount; } //Incremented on each Init, lets the frontend know a ROM has been (re)loaded
+
+	//Held by the host, the guest only sees it from the next GuestEvent::InputSample
+	void							SetKeyState( const uint8_t iKey,const bool bPressed ) { if( iKey < 0x10 ) m_aHostKeys[ iKey ] = bPressed; }
+	uint8_t							GetKeyState( const uint8_t iKey ) const { return iKey < 0x10 ? m_aKeys[ iKey ] : 0; }
+	uint8_t							IsAnyKeyPress() const;
+
 	static const std::array< std::string,7 >* GetPlatformsSupported() { return &m_sSupportedPlatform; }
-	static Quirk					m_oCurrentQuirk;
-	void							SetIfCurrentRomXoChip( bool bXoChip ) { m_bXoCHIP = bXoChip; }
-	uint16_t						GetMaxSizeMemory() const { return m_bXoCHIP ? 0xFFFF : 0xFFF; }
+	Quirk							m_oCurrentQuirk;
+	void							SetIfCurrentRomXoChip( bool bXoChip );
+
+	//Unsupported dispatches fall back to the opcode table
+	void							SetInterpreterDispatch( InterpreterDispatch oDispatch );
+	InterpreterDispatch				GetInterpreterDispatch() const { return m_oDispatch; }
+	static bool						IsDispatchSupported( const InterpreterDispatch oDispatch );
+	const DecodeCacheStats&			GetDecodeCacheStats() const { return m_oDecodeCacheStats; }
+
+	void							SetExecutionEngine( const ExecutionEngine oEngine );
+	ExecutionEngine					GetExecutionEngine() const { return m_oEngine; }
+	const BlockCacheStats&			GetBlockCacheStats() const { return m_oBlockCacheStats; }
+	const IdleLoopStats&			GetIdleLoopStats() const { return m_oIdleLoopStats; }
+	bool							HasAotModule() const { return m_pAotModule != nullptr; }
+	//CXNN draws from a generator owned by the machine. Once a seed is set every Init / reset replays the same bytes, until then each one starts from the clock
+	void							SetRandomSeed( const uint32_t iSeed );
+	void							SetRandomSeedFromClock();
 
 private:
 
-	Chip8();
-	~Chip8();
+	using MemoryPage = std::array< uint8_t,MemoryMap::MEMORY_PAGE_SIZE >;
+	using InterpreterArea = std::array< uint8_t,MemoryMap::START_ROM_MEMORY_ADDRESS >; //Below the ROM, holds the fonts
 
 	void _Reset();
-	void _LoadFont();
+	void _ResetMachineState();
+	void _AllocateMemory( const uint32_t iSize );
+	void _GrowMemory( const uint32_t iSize );
+	static InterpreterArea _BuildInterpreterArea();
 	void _LoadROM( const char* sROMToLoad );
+	void _ApplyRomImage();
 
 	void _FetchDecode_Opcode();
+	template< InterpreterDispatch oDispatch > void _FetchDecode();
+	//Every run loop stops after iBudget instructions, or earlier when the machine pauses or stops
+	template< InterpreterDispatch oDispatch > void _RunInterpreter( const uint32_t iBudget );
+#ifdef DEBUG_INFO
+	void _RunInstrumented( const bool bForceNextStep,const uint32_t iBudget );
+#endif
+	template< size_t iQuirks > void _ExecuteSwitch();
+	template< size_t iQuirks > void _ExecuteHandler( const uint8_t iHandler );
+	template< size_t iQuirks > void _RunThreaded( const uint32_t iBudget );
+	void _SelectQuirkSpecialization();
+	uint8_t _ReadMemoryAfter( const uint16_t iMaskedAddr,const uint32_t iOffset ) const
+	{
+		const uint32_t iAddr = iMaskedAddr + iOffset;
+		return m_aPages[ iAddr >> MemoryMap::MEMORY_PAGE_SHIFT ][ iAddr & ( MemoryMap::MEMORY_PAGE_SIZE - 1 ) ];
+	}
+	uint8_t _ReadMemory( const uint16_t iAddr ) const { return _ReadMemoryAfter( iAddr & m_iAddressMask,0 ); }
+	uint16_t _ReadOpcode( const uint16_t iAddr ) const
+	{
+		const uint16_t iMasked = iAddr & m_iAddressMask;
+		return _ReadMemoryAfter( iMasked,0 ) << 8 | _ReadMemoryAfter( iMasked,1 );
+	}
+	void _MirrorGuardPages();
+	void _WriteMemory( const uint16_t iAddr,const uint8_t iValue );
+	void _WriteMemoryBlock( const uint16_t iAddr,const uint8_t* pSrc,const uint32_t iSize );
+	void _InvalidateCode( const uint16_t iAddr,const uint32_t iSize );
+	void _CopyPageOnWrite( const uint16_t iPage );
+	void _FlushDecodeCache();
+
+	struct TranslatedBlock;
+	void _RunBlocks( const uint32_t iBudget );
+	void _RunUntil( const uint64_t iCycle,const bool bForceNextStep );
+	bool _FireDueEvents();
+	void _GovernInstructionsPerFrame();
+	void _CheckIdleLoop();
+	bool _SimulateIdleLoop( const uint16_t iTarget,const uint32_t iMaxInstructions,uint32_t& iLength ) const;
+	TranslatedBlock* _FindOrTranslateBlock( const uint16_t iStartPC );
+	static uint32_t _ScanBlock( const Chip8& oCpu,const uint16_t iStartPC,std::vector< uint16_t >& aOpcodes,uint16_t& iFollowingOpcode );
+	JitCompiler::NativeBlock _FindAotBlock( const uint16_t iStartPC,const std::vector< uint16_t >& aOpcodes,const uint16_t iFollowingOpcode ) const;
+	void _InvalidateBlocks( const uint16_t iAddr );
+	void _FlushBlockCache();
+	static bool _IsBlockTerminator( const uint16_t iOpcode );
+	static bool _IsSkipOpcode( const uint16_t iOpcode );
+	static void _JitExecuteOpcode( Chip8* pCpu,uint32_t iOpcode );
+	JitCompiler::GuestLayout _GetJitLayout() const;
 	void _UpdateTimers();
-	bool _IsEndReached();
+	void _SeedRandom();
+	void _RefillRandomBytes();
+	void _CheckJump( const uint16_t iJumpAddress );
 
-	std::array< Data<uint8_t>,0xFFFF > m_aMemory;
-	Data<uint8_t> m_aRegisters[ 16 ];
-	Data<uint8_t> m_aFlags[ 16 ]; //for FX75 // FX85
-	Data<uint16_t> m_iI; //Address register
+	//Everything an instruction touches besides memory, packed in one cache line ( 57 bytes )
+	alignas( 64 ) Data<uint8_t> m_aRegisters[ 16 ];
 	Data<uint16_t> m_aStack[ 16 ];
-	Data<uint8_t> m_iSP; //Stack pointer
+	Data<uint16_t> m_iI; //Address register
 	Data<uint16_t> m_iPC; //Program counter
 	uint16_t m_iCurrentOpcode;
-
-	uint16_t m_iLastOpcode;
-	long long unsigned							m_iCycle;
-	mutable RunningState						m_oState;
-
+	Data<uint8_t> m_iSP; //Stack pointer
 	Data<uint8_t> m_iDelay_timer;
 	Data<uint8_t> m_iSound_timer;
 
-	uint8_t m_aFontset[ 80 ] =
+	std::vector< uint8_t* > m_aPages; //4K, or 64K once the ROM is known to be XO-CHIP, then the guard pages. Font, ROM and zero pages are shared until the guest writes them
+	uint16_t m_iAddressMask; //Address space size - 1, 0xFFF or 0xFFFF
+	Data<uint8_t> m_aFlags[ 16 ]; //for FX75 // FX85
+	long long unsigned							m_iCycle;
+	long long unsigned							m_iInstructionsRun;
+	RunningState								m_oState;
+	HaltState									m_oHalt;
+
+	//Mapped by every machine through s_aInterpreterArea, a ROM writing over it gets its own copy of the page
+	static constexpr uint8_t s_aFontset[ 80 ] =
 	{
 		0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
 		0x20, 0x60, 0x20, 0x20, 0x70, // 1
@@ -220,7 +367,7 @@ private:
 		0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 	};
 
-	uint8_t m_aSuperFontset[ 160 ] =
+	static constexpr uint8_t s_aSuperFontset[ 160 ] =
 	{
 		0x3C, 0x7E, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0x7E, 0x3C, // 0
 		0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
@@ -240,31 +387,54 @@ private:
 		0xFF, 0xFF, 0xC0, 0xC0, 0xF8, 0xF8, 0xC0, 0xC0, 0xC0, 0xC0  // F
 	};
 
-	uint8_t m_iCountBeforeStop;
+	uint8_t m_iCountBeforeStop; //Runs of a JMP on itself in a row
 	uint8_t										m_iPreviousKeyPressed;
 
-	std::chrono::steady_clock::time_point		m_iLastTimeUpdate;
-	const char* m_sCurrentRomLoaded;//Don't set that without SetROMPathFileToLoad function
+	std::string m_sCurrentRomLoaded;//Don't set that without SetROMPathFileToLoad function
+
 
-	std::chrono::steady_clock::time_point		m_iTimeLastFrame;
 
+	int											m_iInstructionsPerFrame;
+	int											m_iMaxInstructionsPerFrame; //Set by the user or the database, the governor never goes above
 
-	static Chip8* m_pSingleton;
-	static  int									m_iInstructionsPerFrame;
+	//Frame being run, and the busiest one of the governor window
+	uint64_t									m_iFrameStartCycle;
+	uint32_t									m_iFrameActiveCycles; //Run before the first idle of the frame
+	bool										m_bFrameIdled;
+	bool										m_bIpfGovernor;
+	uint32_t									m_iGovernorPeak;
+	uint16_t									m_iGovernorFrames;
 
 	typedef void ( Chip8::* fct_opcode )( );
-	//Opcodes array
-	std::array< fct_opcode,16 > m_aMainTable;
-	std::array< fct_opcode,16 > m_a0x8_Table;
-	std::array< fct_opcode,16 > m_a0xF_Table;
-
-	//Functions
-	inline void x0_Dispatch();
-	inline void x8_Dispatch();
-	inline void xE_Dispatch();
-	inline void xF_Dispatch();
-	template< typename T,size_t N >
-	inline void CheckOpcodeAndExec( const T iNibble,const std::array<fct_opcode,N>& aTable );
+	static constexpr size_t OPCODE_HANDLER_COUNT = 51; //Entries of CHIP8_OPCODE_HANDLERS
+	static constexpr size_t GENERIC_QUIRKS = PLATFORM_QUIRKS.size(); //Specialization reading m_oCurrentQuirk, for custom or edited quirks
+	static constexpr size_t QUIRK_SPECIALIZATIONS = PLATFORM_QUIRKS.size() + 1;
+
+	//Everything that depends on the quirks, compiled once per platform
+	struct QuirkSpecialization
+	{
+		std::array< fct_opcode,OPCODE_HANDLER_COUNT > aHandlers;
+		fct_opcode pExecuteSwitch;
+		void ( Chip8::*pExecuteHandler )( const uint8_t iHandler );
+		void ( Chip8::*pRunThreaded )( const uint32_t iBudget );
+	};
+
+	//Platform quirks are constants there, every test on them is folded away
+	template< size_t iQuirks > const Quirk& _GetQuirks() const
+	{
+		if constexpr( iQuirks == GENERIC_QUIRKS )
+			return m_oCurrentQuirk;
+		else
+			return PLATFORM_QUIRKS[ iQuirks ];
+	}
+
+	fct_opcode _DecodeOpcode( const uint16_t iOpcode ) const { return m_pQuirkSpecialization->aHandlers[ s_aHandlerIds[ iOpcode ] ]; }
+	static constexpr uint8_t _DecodeHandlerId( const uint16_t iOpcode );
+	static constexpr std::array< uint8_t,0x10000 > _BuildHandlerIdTable();
+	template< size_t iQuirks > static constexpr QuirkSpecialization _BuildQuirkSpecialization();
+	template< size_t... aQuirks > static constexpr std::array< QuirkSpecialization,QUIRK_SPECIALIZATIONS > _BuildQuirkSpecializations( std::index_sequence< aQuirks... > );
+	static const std::array< uint8_t,0x10000 > s_aHandlerIds; //Index in CHIP8_OPCODE_HANDLERS, also the label of the threaded interpreter
+	static const std::array< QuirkSpecialization,QUIRK_SPECIALIZATIONS > s_aQuirkSpecializations;
 
 	//Opcodes
 	inline void CLS();
@@ -272,7 +442,7 @@ private:
 	inline void CALL();
 
 	inline void JMP();
-	inline void JMP_NNN();
+	template< size_t iQuirks > inline void JMP_NNN();
 
 	inline void SNE_VX_NN();
 	inline void SNE_VX_VY();
@@ -290,18 +460,18 @@ private:
 	inline void LD_ST_VX();
 	inline void LD_I_FONT();
 	inline void LD_I_SUPER_FONT();
-	inline void LD_I_VX();
-	inline void LD_VX_I();
+	template< size_t iQuirks > inline void LD_I_VX();
+	template< size_t iQuirks > inline void LD_VX_I();
 	inline void SAVEFLAGS_VX();
 	inline void LOADFLAGS_VX();
 	inline void SAVE_RANGE();
 	inline void LOAD_RANGE();
 	inline void HIRES();
 	inline void LORES();
-	inline void SCROLL_DOWN();
-	inline void SCROLL_UP();
-	inline void SCROLL_LEFT();
-	inline void SCROLL_RIGHT();
+	template< size_t iQuirks > inline void SCROLL_DOWN();
+	template< size_t iQuirks > inline void SCROLL_UP();
+	template< size_t iQuirks > inline void SCROLL_LEFT();
+	template< size_t iQuirks > inline void SCROLL_RIGHT();
 	inline void QUIT();
 
 	inline void ADD_VX_NN();
@@ -311,13 +481,13 @@ private:
 	inline void SUB_VX_VY();
 	inline void SUBN_VX_VY();
 
-	inline void OR();
-	inline void AND();
-	inline void XOR();
-	inline void SHR();
-	inline void SHL();
+	template< size_t iQuirks > inline void OR();
+	template< size_t iQuirks > inline void AND();
+	template< size_t iQuirks > inline void XOR();
+	template< size_t iQuirks > inline void SHR();
+	template< size_t iQuirks > inline void SHL();
 	inline void RND();
-	inline void DRAW();
+	template< size_t iQuirks > inline void DRAW();
 	inline void BCD();
 
 	inline void SKP();
@@ -326,6 +496,7 @@ private:
 	inline void PLANE();
 	inline void AUDIO();
 	inline void AUDIO_PITCH();
+	inline void UNKNOWN_OPCODE();
 
 	inline const uint8_t GetX();
 	inline const uint8_t GetY();
@@ -336,27 +507,74 @@ private:
 	inline void SkipNextBlock();
 
 #ifdef DEBUG_INFO
-	static uint16_t	m_iAdressBreakpoint;
+	uint16_t	m_iAdressBreakpoint;
+	bool								m_bDebuggerAttached;
+	Disassembler						m_oDisassembler;
 #endif
 
-	const Input* m_pInputInstance;
-	SoundManager* m_pSoundManagerInstance;
-	Display* m_pDisplayInstance;
-	static uint8_t iHexToIndex[];
-
-	struct alignas ( 16 ) DecodedOpcode
+	FrameBuffer							m_oFrameBuffer;
+	AudioRegisters						m_oAudio;
+	std::shared_ptr< const RomImage >	m_pRom; //Last ROM loaded, never null. Shared with the pool and every machine recycled on it
+	std::vector< bool >					m_aSharedPages; //Page still mapped from s_aZeroPage, s_aInterpreterArea or the ROM image
+	std::vector< std::unique_ptr< MemoryPage > > m_aPrivatePages; //Copies made on write, the first m_iPrivatePagesUsed are mapped. Kept for the next ROM
+	size_t								m_iPrivatePagesUsed;
+	static MemoryPage					s_aZeroPage; //Never written : _WriteMemory copies a shared page before storing into it
+	static InterpreterArea				s_aInterpreterArea;
+	uint8_t								m_aKeys[ 0x10 ]; //As sampled on the guest clock
+	uint8_t								m_aHostKeys[ 0x10 ];
+	EventScheduler						m_oScheduler;
+	uint32_t							m_iLoadCount;
+
+	struct DecodedOpcode
 	{
 		fct_opcode fct = nullptr;
-		uint16_t NNN = 0;
-		uint8_t X = 0;
-		uint8_t Y = 0;
-		uint8_t NN = 0;
-		uint8_t N = 0;
+		uint16_t iOpcode = 0;
 	};
-	std::array<DecodedOpcode,4096 > m_aMirorMemory;
-	DecodedOpcode* m_pCurrentOpcode;
-
-	std::mt19937 m_iRng;
-	static std::array< std::string,7 > m_sSupportedPlatform;
+	//Predecode cache entry, the handler is its index in the current specialization so an entry fits in 4 bytes
+	static constexpr uint8_t NOT_DECODED = 0xFF;
+	struct PredecodedOpcode
+	{
+		uint16_t iOpcode = 0;
+		uint8_t iHandler = NOT_DECODED;
+	};
+	std::vector< PredecodedOpcode >		m_aDecodeCache; //One entry per PC of the address space
+	DecodeCacheStats					m_oDecodeCacheStats;
+	InterpreterDispatch					m_oDispatch;
+	const QuirkSpecialization*			m_pQuirkSpecialization;
+	Quirk								m_oSpecializedQuirk; //m_oCurrentQuirk when the specialization was picked
+
+	//Ends on anything that leaves the straight line ( jumps, calls, skips ), on DRAW and on memory stores
+	struct TranslatedBlock
+	{
+		uint16_t						iStartPC = 0;
+		uint32_t						iEndPC = 0; //Exclusive, F000 NNNN operand and opcode after a final skip included
+		std::vector< DecodedOpcode >	aOps;
+		uint16_t						aSuccessorPC[ 2 ] = { 0 };
+		TranslatedBlock*				aSuccessors[ 2 ] = { nullptr };
+		JitCompiler::NativeBlock		pNative = nullptr;
+		bool							bValid = true;
+	};
+	std::unordered_map< uint16_t,std::unique_ptr< TranslatedBlock > > m_aBlocks;
+	std::vector< std::unique_ptr< TranslatedBlock > > m_aRetiredBlocks; //Invalidated while maybe still running, freed on next frame
+	std::vector< bool >					m_aTranslatedCode; //Bytes read by at least one block, sized like the memory
+	BlockCacheStats						m_oBlockCacheStats;
+	ExecutionEngine						m_oEngine;
+	std::unique_ptr< JitCompiler >		m_pJit;
+	const AotModule*					m_pAotModule; //Generated code registered for the loaded ROM, if any
+
+	IdleLoopStats						m_oIdleLoopStats;
+	uint32_t							m_iIdleLoopLength; //Instructions per iteration of the loop to skip
+	uint16_t							m_iIdleLoopTarget; //Last loop checked, retried less and less often while it isn't idle
+	uint16_t							m_iIdleLoopCooldown;
+	uint8_t								m_iIdleLoopFailures;
+
+	//CXNN bytes, made RANDOM_BATCH_SIZE at a time by SplitMix64
+	static constexpr uint8_t RANDOM_BATCH_SIZE = 64;
+	uint64_t							m_iRandomState;
+	uint32_t							m_iRandomSeed;
+	bool								m_bFixedRandomSeed;
+	uint8_t								m_iRandomIndex; //Next unused byte of m_aRandomBytes
+	uint8_t								m_aRandomBytes[ RANDOM_BATCH_SIZE ];
+	static const std::array< std::string,7 > m_sSupportedPlatform;
 	bool								m_bXoCHIP;
 };
\ No newline at end of file
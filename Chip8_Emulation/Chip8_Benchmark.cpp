@@ -0,0 +1,174 @@
+#include "Chip8.h"
+#include "MachinePool.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+
+//Head-to-head benchmark : every ROM goes through every dispatch / engine on the same seed, the fastest wins for this host
+#define DEFAULT_FRAMES_TO_RUN 600
+#define DEFAULT_REPEAT 3
+#define BENCHMARK_RANDOM_SEED 0xC8C8C8C8
+
+struct BenchmarkConfig
+{
+	const char*						sName;
+	InterpreterDispatch				oDispatch;
+	ExecutionEngine					oEngine;
+};
+
+static const BenchmarkConfig s_aConfigs[] =
+{
+	{ "switch",		InterpreterDispatch::Switch,			ExecutionEngine::Interpreter },
+	{ "predecode",	InterpreterDispatch::PredecodeCache,	ExecutionEngine::Interpreter },
+	{ "table",		InterpreterDispatch::OpcodeTable,		ExecutionEngine::Interpreter },
+	{ "threaded",	InterpreterDispatch::Threaded,			ExecutionEngine::Interpreter },
+	{ "blocks",		InterpreterDispatch::PredecodeCache,	ExecutionEngine::BasicBlocks },
+	{ "jit",		InterpreterDispatch::PredecodeCache,	ExecutionEngine::Jit },
+	{ "aot",		InterpreterDispatch::PredecodeCache,	ExecutionEngine::Aot },
+};
+
+struct BenchmarkResult
+{
+	long long unsigned				iInstructions = 0;
+	double							fNsPerInstruction = 0.0;
+	MachineFootprint				oFootprint; //Per instance, once the frames have run ( decoded / translated code included )
+};
+
+static bool IsConfigAvailable( const BenchmarkConfig& oConfig,const Chip8& oCpu )
+{
+	if( !Chip8::IsDispatchSupported( oConfig.oDispatch ) )
+		return false;
+	if( oConfig.oEngine == ExecutionEngine::Jit && !JitCompiler::IsSupported() )
+		return false;
+	if( oConfig.oEngine == ExecutionEngine::Aot && !oCpu.HasAotModule() )
+		return false;
+	return true;
+}
+
+//Best of iRepeat fresh runs, the translation / decode warm-up is part of the measure like it is for the player
+//Every run recycles the same pool slot, the ROM is only read from disk once
+static BenchmarkResult RunConfig( const Chip8::KeyAccess& oKey,MachinePool& oPool,const char* sROMToLoad,const BenchmarkConfig& oConfig,const long long iFrames,const int iRepeat )
+{
+	BenchmarkResult oResult;
+	for( int iRun = 0; iRun < iRepeat; ++iRun )
+	{
+		Chip8* pCpu = oPool.Acquire( oKey,sROMToLoad );
+		if( pCpu == nullptr )
+			break;
+		pCpu->SetRandomSeed( BENCHMARK_RANDOM_SEED );
+		pCpu->SetInterpreterDispatch( oConfig.oDispatch );
+		pCpu->SetExecutionEngine( oConfig.oEngine );
+		pCpu->AskForState( oKey,RunningState::Running );
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for( long long iFrame = 0; iFrame < iFrames && pCpu->IsRunning(); ++iFrame )
+			pCpu->EmulateCycle( oKey );
+		double fElapsed = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+		const long long unsigned iInstructions = pCpu->GetInstructionsRun();
+		const MachineFootprint oFootprint = pCpu->GetFootprint();
+		oPool.Release( pCpu );
+		if( iInstructions == 0 )
+			continue;
+
+		double fNsPerInstruction = fElapsed / iInstructions;
+		if( oResult.iInstructions == 0 || fNsPerInstruction < oResult.fNsPerInstruction )
+		{
+			oResult.iInstructions = iInstructions;
+			oResult.fNsPerInstruction = fNsPerInstruction;
+			oResult.oFootprint = oFootprint;
+		}
+	}
+	return oResult;
+}
+
+int main( int argc,char* argv[] )
+{
+	if( argc < 2 )
+	{
+		std::cerr << "Usage: " << argv[ 0 ] << " <rom> [rom ...] [--frames N] [--repeat R]" << std::endl;
+		return -1;
+	}
+
+	std::vector< const char* > aROMs;
+	long long iFrames = DEFAULT_FRAMES_TO_RUN;
+	int iRepeat = DEFAULT_REPEAT;
+	for( int i = 1; i < argc; ++i )
+	{
+		std::string sArg = argv[ i ];
+		if( sArg == "--frames" && i + 1 < argc )
+			iFrames = std::max( 1LL,std::stoll( argv[ ++i ] ) );
+		else if( sArg == "--repeat" && i + 1 < argc )
+			iRepeat = std::max( 1,std::stoi( argv[ ++i ] ) );
+		else
+			aROMs.push_back( argv[ i ] );
+	}
+
+	Chip8::KeyAccess oKey;
+	MachinePool oPool( 1 );
+	const size_t iConfigCount = sizeof( s_aConfigs ) / sizeof( s_aConfigs[ 0 ] );
+	std::vector< double > aTotalNs( iConfigCount,0.0 );
+	std::vector< double > aTotalInstructions( iConfigCount,0.0 );
+	std::vector< int > aMeasured( iConfigCount,0 );
+	int iLoadedROMs = 0;
+
+	std::cout << std::left << std::setw( 24 ) << "ROM" << std::setw( 12 ) << "Config" << std::right << std::setw( 14 ) << "Instructions" << std::setw( 12 ) << "ns/instr" << std::setw( 10 ) << "vs switch" << std::setw( 14 ) << "Bytes/machine" << std::endl;
+	for( const char* sROMToLoad : aROMs )
+	{
+		Chip8 oProbe;
+		oProbe.Init( oKey,sROMToLoad );
+		if( oProbe.GetCurrentRomLoaded() == nullptr )
+			continue;
+
+		++iLoadedROMs;
+		std::string sName = std::filesystem::path( sROMToLoad ).filename().string();
+		const MachineFootprint oFootprint = oProbe.GetFootprint();
+		std::cout << std::left << std::setw( 24 ) << sName << "loaded : " << oFootprint.Total() << " bytes per machine ( object " << oFootprint.iObject
+			<< ", memory " << oFootprint.iMemory << ", predecode " << oFootprint.iDecodeCache << ", blocks " << oFootprint.iBlocks << " ), " << oFootprint.iSharedMemory << " ROM bytes shared" << std::right << std::endl;
+		double fSwitchNs = 0.0;
+		for( size_t iConfig = 0; iConfig < iConfigCount; ++iConfig )
+		{
+			const BenchmarkConfig& oConfig = s_aConfigs[ iConfig ];
+			if( !IsConfigAvailable( oConfig,oProbe ) )
+				continue;
+
+			BenchmarkResult oResult = RunConfig( oKey,oPool,sROMToLoad,oConfig,iFrames,iRepeat );
+			if( oResult.iInstructions == 0 )
+				continue;
+
+			if( oConfig.oDispatch == InterpreterDispatch::Switch && oConfig.oEngine == ExecutionEngine::Interpreter )
+				fSwitchNs = oResult.fNsPerInstruction;
+			aTotalNs[ iConfig ] += oResult.fNsPerInstruction * oResult.iInstructions;
+			aTotalInstructions[ iConfig ] += static_cast< double >( oResult.iInstructions );
+			++aMeasured[ iConfig ];
+
+			std::cout << std::left << std::setw( 24 ) << sName << std::setw( 12 ) << oConfig.sName << std::right << std::setw( 14 ) << oResult.iInstructions
+				<< std::setw( 12 ) << std::fixed << std::setprecision( 3 ) << oResult.fNsPerInstruction;
+			if( fSwitchNs > 0.0 )
+				std::cout << std::setw( 9 ) << std::setprecision( 2 ) << fSwitchNs / oResult.fNsPerInstruction << "x";
+			else
+				std::cout << std::setw( 10 ) << "-";
+			std::cout << std::setw( 14 ) << oResult.oFootprint.Total() << std::endl;
+		}
+	}
+
+	//Only the interpreter dispatches compete for the default, engines are a separate choice
+	//Weighted by the instructions run : a ROM waiting on a key or a timer runs a handful, its ns/instr is mostly frame overhead
+	int iBestDispatch = -1;
+	for( size_t iConfig = 0; iConfig < iConfigCount; ++iConfig )
+	{
+		if( s_aConfigs[ iConfig ].oEngine != ExecutionEngine::Interpreter || aMeasured[ iConfig ] != iLoadedROMs )
+			continue;
+		if( iBestDispatch == -1 || aTotalNs[ iConfig ] / aTotalInstructions[ iConfig ] < aTotalNs[ iBestDispatch ] / aTotalInstructions[ iBestDispatch ] )
+			iBestDispatch = static_cast< int >( iConfig );
+	}
+	if( iBestDispatch != -1 )
+		std::cout << "Fastest dispatch on this host : " << s_aConfigs[ iBestDispatch ].sName << std::endl;
+
+	return 0;
+}
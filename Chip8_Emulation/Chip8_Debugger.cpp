@@ -30,7 +30,7 @@
 
 #include "Chip8_Debugger.h"
 #include "Display.h"
-#include "Chip8.h"
+#include "EmulationThread.h"
 #include "Disassembler.h"
 
 #ifdef _WIN32
@@ -50,7 +50,9 @@ static std::vector<uint16_t> m_aAdress = {};
 
 Chip8_Debugger::Chip8_Debugger() :
 	m_pWindow( nullptr ),
-	m_pCPU( nullptr ),
+	m_pEmulation( nullptr ),
+	m_pSnapshot( nullptr ),
+	m_pDisassembledRom( nullptr ),
 	m_iCycleIndex( 0 ),
 	m_iRegisterSelected( 0 ),
 	m_iMemorySelected( 0 ),
@@ -69,7 +71,7 @@ Chip8_Debugger::~Chip8_Debugger()
 	}
 }
 
-void Chip8_Debugger::Init( GLFWwindow* mainWindow,const Chip8* pCPU )
+void Chip8_Debugger::Init( GLFWwindow* mainWindow,EmulationThread* pEmulation )
 {
 #ifdef DEBUG_INFO
 	float main_scale = ImGui_ImplGlfw_GetContentScaleForMonitor( glfwGetPrimaryMonitor() ); // Valid on GLFW 3.3+ only
@@ -95,29 +97,31 @@ void Chip8_Debugger::Init( GLFWwindow* mainWindow,const Chip8* pCPU )
 #endif
 	ImGui_ImplOpenGL3_Init( "#version 330" );
 
-	if( pCPU != nullptr )
-		m_pCPU = pCPU;
+	if( pEmulation != nullptr )
+	{
+		m_pEmulation = pEmulation;
+		m_pEmulation->Push( MachineCommandType::AttachDebugger,1 );
+	}
 
 	ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;
 #endif
 }
 
-void Chip8_Debugger::Update( const double* time )
+void Chip8_Debugger::Update( const double* time,const MachineSnapshot& oSnapshot )
 {
 #ifdef DEBUG_INFO
-	assert( m_pCPU != nullptr );
+	assert( m_pEmulation != nullptr );
+	m_pSnapshot = &oSnapshot;
 
 	// Poll and handle events (inputs, window resize, etc.)
 	// You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
 	// - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application, or clear/overwrite your copy of the mouse data.
 	// - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application, or clear/overwrite your copy of the keyboard data.
 	// Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
+	//Not called while the window is minimized, main blocks on the window events instead
 	glfwPollEvents();
-	if( glfwGetWindowAttrib( m_pWindow,GLFW_ICONIFIED ) != 0 )
-	{
-		ImGui_ImplGlfw_Sleep( 10 );
-		return;
-	}
+
+	_TrackChanges();
 
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
@@ -132,15 +136,15 @@ void Chip8_Debugger::Update( const double* time )
 			for( int i = 0; i < 0x10; ++i )
 			{
 				std::string sText = "V" + std::format( "{:X}:",i );
-				FormatDebugData( sText,"%02X",m_pCPU->GetRegisters()[ i ],m_iRegisterSelected,iIndex );
+				FormatDebugData( sText,"%02X",m_pSnapshot->aRegisters[ i ],m_oPreviousState.aRegisters[ iIndex ],m_iRegisterSelected,iIndex );
 			}
 
 			ImGui::NewLine();
-			FormatDebugData( "I :","%#06X",m_pCPU->GetI(),m_iRegisterSelected,iIndex );
-			FormatDebugData( "SP:","%#06X",m_pCPU->GetSP(),m_iRegisterSelected,iIndex );
-			FormatDebugData( "PC:","%#06X",m_pCPU->GetPC(),m_iRegisterSelected,iIndex );
-			FormatDebugData( "DT:","%03X",m_pCPU->GetDelayTimer(),m_iRegisterSelected,iIndex );
-			FormatDebugData( "ST:","%03X",m_pCPU->GetSoundTimer(),m_iRegisterSelected,iIndex );
+			FormatDebugData( "I :","%#06X",m_pSnapshot->iI,m_oPreviousState.aRegisters[ iIndex ],m_iRegisterSelected,iIndex );
+			FormatDebugData( "SP:","%#06X",m_pSnapshot->iSP,m_oPreviousState.aRegisters[ iIndex ],m_iRegisterSelected,iIndex );
+			FormatDebugData( "PC:","%#06X",m_pSnapshot->iPC,m_oPreviousState.aRegisters[ iIndex ],m_iRegisterSelected,iIndex );
+			FormatDebugData( "DT:","%03X",m_pSnapshot->iDelayTimer,m_oPreviousState.aRegisters[ iIndex ],m_iRegisterSelected,iIndex );
+			FormatDebugData( "ST:","%03X",m_pSnapshot->iSoundTimer,m_oPreviousState.aRegisters[ iIndex ],m_iRegisterSelected,iIndex );
 		}
 		ImGui::EndListBox();
 	}
@@ -148,11 +152,10 @@ void Chip8_Debugger::Update( const double* time )
 
 	if( ImGui::Begin( "Controls",nullptr ) )
 	{
-		static Chip8::KeyAccess			oKey;
 		if( ImGui::Button( "Load Rom" ) )
 		{
 			ENABLE_GLOBAL_LEAK_DETECTION();
-			m_pCPU->AskForState( oKey, RunningState::Pause );//The thread should be put in pause with GetOpenFileNameA call anyway
+			m_pEmulation->Push( MachineCommandType::SetState,static_cast< int >( RunningState::Pause ) );//The thread should be put in pause with GetOpenFileNameA call anyway
 #ifdef _WIN32
 			OPENFILENAMEA ofn;
 			char szFile[ 260 ];
@@ -172,17 +175,13 @@ void Chip8_Debugger::Update( const double* time )
 
 			if( GetOpenFileNameA( &ofn ) )
 			{
-				if( m_pCPU->GetCurrentRomLoaded() == nullptr || strcmp( szFile, m_pCPU->GetCurrentRomLoaded() ) != 0 )
-				{
-					m_aAdress.clear();
-					m_pCPU->GetInstance()->SetROMPathFileToLoad( oKey,szFile );
-					m_pCPU->GetInstance()->AskForState( oKey,RunningState::LoadNewRom );
-				}
+				if( m_pSnapshot->GetCurrentRomLoaded() == nullptr || strcmp( szFile, m_pSnapshot->GetCurrentRomLoaded() ) != 0 )
+					m_pEmulation->PushLoadRom( szFile );
 			}
 			else
 			{
-				if( m_pCPU->GetCurrentRomLoaded() != nullptr )
-					m_pCPU->AskForState( oKey,RunningState::Running );
+				if( m_pSnapshot->GetCurrentRomLoaded() != nullptr )
+					m_pEmulation->Push( MachineCommandType::SetState,static_cast< int >( RunningState::Running ) );
 			}
 			DISABLE_GLOBAL_LEAK_DETECTION();
 #else
@@ -191,58 +190,53 @@ void Chip8_Debugger::Update( const double* time )
 			char* result = fgets( szFile, 260, f) ;
 			if ( result != nullptr )
 			{
-				if( m_pCPU->GetCurrentRomLoaded() == nullptr || strcmp( szFile, m_pCPU->GetCurrentRomLoaded() ) != 0 )
+				if( m_pSnapshot->GetCurrentRomLoaded() == nullptr || strcmp( szFile, m_pSnapshot->GetCurrentRomLoaded() ) != 0 )
 				{
 					std::string sPath = std::string( result );
 					size_t size = sPath.size();
 					if ( sPath[size - 1] == '\n' )
 						sPath.resize( size - 1 );
 
-					m_aAdress.clear();
-					m_pCPU->GetInstance()->SetROMPathFileToLoad( oKey, sPath );
-					m_pCPU->GetInstance()->AskForState( oKey,RunningState::LoadNewRom );
+					m_pEmulation->PushLoadRom( sPath );
 				}
 			}
 			else
 			{
-				if( m_pCPU->GetCurrentRomLoaded() != nullptr )
-					m_pCPU->AskForState( oKey,RunningState::Running );
+				if( m_pSnapshot->GetCurrentRomLoaded() != nullptr )
+					m_pEmulation->Push( MachineCommandType::SetState,static_cast< int >( RunningState::Running ) );
 			}
 #endif
 		}
 
 		ImGui::Separator();
 
-		if( m_pCPU->IsPause() )
+		if( m_pSnapshot->IsPause() )
 			ImGui::PushStyleColor( ImGuiCol_Button,ImVec4( 0.5f,0.f,0.f,0.62f ) );
-		else if( m_pCPU->IsStop() )
+		else if( m_pSnapshot->IsStop() )
 			ImGui::PushStyleColor( ImGuiCol_Button,ImVec4( 0.37f,0.0f,0.0f,0.62f ) );
 		else
 			ImGui::PushStyleColor( ImGuiCol_Button,ImVec4( 0.35f,0.40f,0.61f,0.62f ) );
 
-		if( ImGui::Button( "Pause" ) && m_pCPU->GetCurrentRomLoaded() != nullptr && !m_pCPU->IsStop() )
-			m_pCPU->AskForState( oKey,m_pCPU->IsPause() ? RunningState::Running : RunningState::Pause );
+		if( ImGui::Button( "Pause" ) && m_pSnapshot->GetCurrentRomLoaded() != nullptr && !m_pSnapshot->IsStop() )
+			m_pEmulation->Push( MachineCommandType::SetState,static_cast< int >( m_pSnapshot->IsPause() ? RunningState::Running : RunningState::Pause ) );
 
-		bool bPause = m_pCPU->IsPause();
+		bool bPause = m_pSnapshot->IsPause();
 		if( bPause )
 			ImGui::PopStyleColor();
 
-		if( ImGui::Button( "Step Next Frame" ) && m_pCPU->GetCurrentRomLoaded() != nullptr && !m_pCPU->IsStop() )
-			m_pCPU->AskForState( oKey,RunningState::StepNextFrame );
+		if( ImGui::Button( "Step Next Frame" ) && m_pSnapshot->GetCurrentRomLoaded() != nullptr && !m_pSnapshot->IsStop() )
+			m_pEmulation->Push( MachineCommandType::SetState,static_cast< int >( RunningState::StepNextFrame ) );
 
 		if( !bPause )
 			ImGui::PopStyleColor();
 
-		if( m_pCPU->IsStop() )
+		if( m_pSnapshot->IsStop() )
 			ImGui::PushStyleColor( ImGuiCol_Button,ImVec4( 0.23f,0.76f,0.18f,0.62f ) );
 		else
 			ImGui::PushStyleColor( ImGuiCol_Button,ImVec4( 0.35f,0.40f,0.61f,0.62f ) );
 
 		if( ImGui::Button( "Reset" ) )
-		{
-			m_aAdress.clear();
-			m_pCPU->AskForState( oKey,RunningState::Reset );
-		}
+			m_pEmulation->Push( MachineCommandType::SetState,static_cast< int >( RunningState::Reset ) );
 
 		ImGui::PopStyleColor();
 		ImGui::Separator();
@@ -250,36 +244,100 @@ void Chip8_Debugger::Update( const double* time )
 		float fFps = 1 / ( TimeManager::GetRefreshTick()->count() / 1000000000.0f );
 		if( ImGui::SliderFloat( "FPS",&fFps,20,120,NULL ) )
 			TimeManager::SetRefreshTick( 1 / fFps );
-		int iIPF = m_pCPU->GetInstructPerFrame();
+		const char* aPacingModes[] = { "Sleep","Hybrid","VSync" };
+		int iPacingMode = static_cast< int >( TimeManager::GetPacingMode() );
+		if( ImGui::Combo( "Pacing",&iPacingMode,aPacingModes,IM_ARRAYSIZE( aPacingModes ) ) )
+			TimeManager::SetPacingMode( static_cast< PacingMode >( iPacingMode ) );
+		Display* pDisplay = Display::GetInstance();
+		const char* aPresentModes[] = { "VSync","Adaptive","Immediate" };
+		int iPresentMode = static_cast< int >( pDisplay->GetPresentMode() );
+		if( ImGui::Combo( "Present",&iPresentMode,aPresentModes,IM_ARRAYSIZE( aPresentModes ) ) )
+			pDisplay->SetPresentMode( static_cast< PresentMode >( iPresentMode ) );
+		if( pDisplay->GetPresentMode() == PresentMode::Adaptive && !pDisplay->IsAdaptiveSupported() )
+		{
+			ImGui::SameLine();
+			ImGui::Text( "unsupported, VSync" );
+		}
+		bool bPresentEarly = TimeManager::IsPresentEarly();
+		if( ImGui::Checkbox( "Present early",&bPresentEarly ) )
+			TimeManager::SetPresentEarly( bPresentEarly );
+		const FrameTimeStats& oFrameStats = TimeManager::GetFrameTimeStats();
+		ImGui::Text( "Frame p50 %.2f p99 %.2f max %.2f ms",oFrameStats.fFrameP50,oFrameStats.fFrameP99,oFrameStats.fFrameMax );
+		ImGui::Text( "Jitter p50 %.2f p99 %.2f max %.2f ms",oFrameStats.fJitterP50,oFrameStats.fJitterP99,oFrameStats.fJitterMax );
+		ImGui::Text( "Timer slack %.3f ms",oFrameStats.fSlack );
+		bool bTurbo = TimeManager::IsTurbo();
+		if( ImGui::Checkbox( "Turbo",&bTurbo ) )
+			TimeManager::SetTurbo( bTurbo );
+		if( bTurbo )
+		{
+			ImGui::SameLine();
+			ImGui::Text( "x%.1f",TimeManager::GetSpeedMultiple() );
+			int iFrameSkip = static_cast< int >( TimeManager::GetTurboFrameSkip() );
+			if( ImGui::SliderInt( "Frame skip",&iFrameSkip,0,100,iFrameSkip == 0 ? "Refresh tick" : "%d" ) )
+				TimeManager::SetTurboFrameSkip( static_cast< uint32_t >( iFrameSkip ) );
+		}
+		//With the governor the slider is its ceiling, the value it picked is shown next to it
+		int iIPF = m_pSnapshot->iMaxInstructionsPerFrame;
 		if( ImGui::SliderInt( "IPF",&iIPF,10,50000,NULL ) )
-			m_pCPU->SetInstructionPerFrame( iIPF );
+			m_pEmulation->Push( MachineCommandType::SetInstructionsPerFrame,iIPF );
+		bool bGovernor = m_pSnapshot->bIpfGovernor;
+		if( ImGui::Checkbox( "IPF governor",&bGovernor ) )
+			m_pEmulation->Push( MachineCommandType::SetIpfGovernor,bGovernor );
+		if( bGovernor )
+		{
+			ImGui::SameLine();
+			ImGui::Text( "%d IPF",m_pSnapshot->iInstructionsPerFrame );
+		}
+
+		const char* aEngines[] = { "Interpreter","Basic Blocks","JIT","AOT" };
+		int iEngine = static_cast< int >( m_pSnapshot->oEngine );
+		if( ImGui::Combo( "Engine",&iEngine,aEngines,IM_ARRAYSIZE( aEngines ) ) )
+			m_pEmulation->Push( MachineCommandType::SetEngine,iEngine );
+
+		const char* aDispatches[] = { "Switch","Predecode Cache","Opcode Table","Threaded" };
+		int iDispatch = static_cast< int >( m_pSnapshot->oDispatch );
+		if( ImGui::Combo( "Dispatch",&iDispatch,aDispatches,IM_ARRAYSIZE( aDispatches ) ) )
+			m_pEmulation->Push( MachineCommandType::SetDispatch,iDispatch );
+		const DecodeCacheStats& oCacheStats = m_pSnapshot->oDecodeCacheStats;
+		ImGui::Text( "Hits %llu | Misses %llu | Invalidations %llu",oCacheStats.iHits,oCacheStats.iMisses,oCacheStats.iInvalidations );
+		const BlockCacheStats& oBlockStats = m_pSnapshot->oBlockCacheStats;
+		ImGui::Text( "Blocks %llu | Chained %llu / %llu | Invalidations %llu",oBlockStats.iBlocksTranslated,oBlockStats.iChainedRuns,oBlockStats.iBlocksRun,oBlockStats.iInvalidations );
+		const IdleLoopStats& oIdleStats = m_pSnapshot->oIdleLoopStats;
+		ImGui::Text( "Idle loops %llu | Cycles skipped %llu",oIdleStats.iSkips,oIdleStats.iSkippedCycles );
+		if( m_pSnapshot->oEngine == ExecutionEngine::Aot )
+			ImGui::Text( m_pSnapshot->bAotModule ? "AOT blocks %llu" : "No AOT module for this ROM",oBlockStats.iAotBlocks );
 
 		ImGui::Separator();
+		bool bAttached = m_pSnapshot->bDebuggerAttached;
+		if( ImGui::Checkbox( "Attached",&bAttached ) ) //Detached, the CPU runs its plain loops and the breakpoint is ignored
+			m_pEmulation->Push( MachineCommandType::AttachDebugger,bAttached );
 		ImGui::Checkbox( "Follow PC",&m_bFollowPc );
-		int iAdress = m_pCPU->GetBreakpointAdress();
+		ImGui::BeginDisabled( !bAttached );
+		int iAdress = m_pSnapshot->iBreakpoint;
 		if( ImGui::InputInt( "Breakpoint", &iAdress,2,10,ImGuiInputTextFlags_CharsHexadecimal ) )
-			m_pCPU->SetBreakpoint( iAdress );
+			m_pEmulation->Push( MachineCommandType::SetBreakpoint,iAdress );
+		ImGui::EndDisabled();
 	}
 	ImGui::End();
 	if( ImGui::Begin( "Quirks",nullptr ) )
 	{
-		if( m_pCPU->m_oCurrentQuirk.bVFResetFlag )
+		if( m_pSnapshot->oQuirk.bVFResetFlag )
 			ImGui::Text( "VFReset On" );
-		if( m_pCPU->m_oCurrentQuirk.bMemoryUnchanged )
+		if( m_pSnapshot->oQuirk.bMemoryUnchanged )
 			ImGui::Text( "Memory Unchanged On" );
-		if( m_pCPU->m_oCurrentQuirk.bMemoryIncrementByX )
+		if( m_pSnapshot->oQuirk.bMemoryIncrementByX )
 			ImGui::Text( "Memory Increment On ( Adress Register++ )" );
-		if( m_pCPU->m_oCurrentQuirk.bDispWaitFlag )
+		if( m_pSnapshot->oQuirk.bDispWaitFlag )
 			ImGui::Text( "VBlank On" );
-		if( !m_pCPU->m_oCurrentQuirk.bWrapFlag )
+		if( !m_pSnapshot->oQuirk.bWrapFlag )
 			ImGui::Text( "Clipping On" );
 		else
 			ImGui::Text( "Wrapping On" );
-		if( m_pCPU->m_oCurrentQuirk.bShiftingFlag )
+		if( m_pSnapshot->oQuirk.bShiftingFlag )
 			ImGui::Text( "Shifting On ( Registers[X] = Registers[Y] >> 1 )" );
-		if( m_pCPU->m_oCurrentQuirk.bQuirkJumpingFlag )
+		if( m_pSnapshot->oQuirk.bQuirkJumpingFlag )
 			ImGui::Text( "Jumping On ( NNN + Registers[0] )" );
-		if( m_pCPU->m_oCurrentQuirk.bLegacySrolling )
+		if( m_pSnapshot->oQuirk.bLegacySrolling )
 			ImGui::Text( "Legacy Scrolling On" );
 	}
 	ImGui::End();
@@ -290,7 +348,7 @@ void Chip8_Debugger::Update( const double* time )
 		{
 			int iIndex = 0;
 			for( int i = 0; i < 0x10; ++i )
-				FormatDebugData( "","%#06X",m_pCPU->GetStack()[ i ],m_iStackSelected,iIndex );
+				FormatDebugData( "","%#06X",m_pSnapshot->aStack[ i ],m_oPreviousState.aStack[ i ],m_iStackSelected,iIndex );
 		}
 		ImGui::EndListBox();
 	}
@@ -301,8 +359,8 @@ void Chip8_Debugger::Update( const double* time )
 		float width = ImGui::GetContentRegionAvail().x;
 		const char* titleLeft = "Display :";
 
-		std::string textPerfDebug = std::format( "{} ms | {} IPF",( *time ),!m_pCPU->IsPause() ? m_pCPU->GetInstructPerFrame() : 0 );
-		ImGui::TextColored( ImVec4( 0.7f,0.7f,0.7f,1.0f ),"%s %s %s",titleLeft,m_pCPU->IsPause() ? "( Pause )" : "( Running )", m_pCPU->GetCurrentRomLoaded() == nullptr ? "None" : m_pCPU->GetCurrentRomLoaded());
+		std::string textPerfDebug = std::format( "{} ms | {} IPF",( *time ),!m_pSnapshot->IsPause() ? m_pSnapshot->iInstructionsPerFrame : 0 );
+		ImGui::TextColored( ImVec4( 0.7f,0.7f,0.7f,1.0f ),"%s %s %s",titleLeft,m_pSnapshot->IsPause() ? "( Pause )" : "( Running )", m_pSnapshot->GetCurrentRomLoaded() == nullptr ? "None" : m_pSnapshot->GetCurrentRomLoaded());
 
 		ImGui::SameLine( width - ImGui::CalcTextSize( textPerfDebug.c_str() ).x );
 		ImGui::TextColored( ImVec4( 0.5f,0.5f,0.5f,1.0f ),"%s",textPerfDebug.c_str() );
@@ -316,11 +374,12 @@ void Chip8_Debugger::Update( const double* time )
 	{
 		static int iBytesPerLine = 32;
 		ImGui::SliderInt( "Bytes per line",&iBytesPerLine,2,32 );
-
-		if( ImGui::BeginListBox( "#",ImVec2( -FLT_MIN,24 * ImGui::GetTextLineHeightWithSpacing() ) ) && m_pCPU->GetMemory() )
+		if( !m_pSnapshot->bDebuggerAttached )
+			ImGui::Text( "Only copied while the debugger is attached" );
+		if( ImGui::BeginListBox( "#",ImVec2( -FLT_MIN,24 * ImGui::GetTextLineHeightWithSpacing() ) ) && m_pSnapshot->iMemorySize != 0 )
 		{
 			ImGuiListClipper clipper;
-			clipper.Begin( ( m_pCPU->GetMaxSizeMemory() / iBytesPerLine ),ImGui::GetTextLineHeightWithSpacing() );
+			clipper.Begin( ( m_pSnapshot->iMemorySize / iBytesPerLine ),ImGui::GetTextLineHeightWithSpacing() );
 
 			while( clipper.Step() )
 			{
@@ -328,7 +387,7 @@ void Chip8_Debugger::Update( const double* time )
 				{
 					ImGui::PushID( line );
 
-					int iMemoryIndex = ( *m_pCPU->GetMemory()->begin() + ( line * iBytesPerLine ) );
+					int iMemoryIndex = line * iBytesPerLine;
 
 					char buffer[ 64 ];
 					snprintf( buffer,sizeof( buffer ),"0x%04X : ",iMemoryIndex );
@@ -347,11 +406,10 @@ void Chip8_Debugger::Update( const double* time )
 						}
 
 						char byteBuffer[ 4 ];
-						const Data<uint8_t>& oData = *( m_pCPU->GetMemory()->begin() + ( iMemoryIndex + i ) );
-						if( m_iCycleIndex != m_pCPU->GetCycleId() )
-							oData.SetDataAsDirty();
+						const uint8_t oData = m_pSnapshot->aMemory[ ( iMemoryIndex + i ) & 0xFFFF ];
+						const bool bChanged = oData != m_oPreviousState.aMemory[ iMemoryIndex + i ];
 
-						ImGui::PushStyleColor( ImGuiCol_Text,oData.IsNULL() ? NULL_DATA_COLOR : oData.HasChanged() ? CHANGE_DATA_COLOR : DEFAULT_DATA_COLOR );
+						ImGui::PushStyleColor( ImGuiCol_Text,oData == 0 ? NULL_DATA_COLOR : bChanged ? CHANGE_DATA_COLOR : DEFAULT_DATA_COLOR );
 
 						snprintf( byteBuffer,sizeof( byteBuffer ),"%02X ", static_cast<uint8_t>( oData ) );
 
@@ -383,11 +441,17 @@ void Chip8_Debugger::Update( const double* time )
 
 	if( ImGui::Begin( "Disassembly",nullptr ) )
 	{
-		if( m_pCPU->GetState() != RunningState::LoadNewRom )
+		//The addresses follow the ROM of the snapshot, a load asked for is only seen once the machine has done it
+		if( m_pSnapshot->pRom.get() != m_pDisassembledRom )
+		{
+			m_aAdress.clear();
+			m_pDisassembledRom = m_pSnapshot->pRom.get();
+		}
+		if( m_pDisassembledRom != nullptr )
 		{
 			if( ImGui::BeginListBox( "#",ImVec2( -FLT_MIN,35 * ImGui::GetTextLineHeightWithSpacing() ) ) )
 			{
-				const auto& aDisassemblyInstructions = Disassembler::GetDisassemblyInstructions();
+				const auto& aDisassemblyInstructions = m_pDisassembledRom->oDisassembler.GetDisassemblyInstructions();
 				if( m_aAdress.empty() )
 				{
 					for ( auto it = aDisassemblyInstructions.begin(); it != aDisassemblyInstructions.end(); ++it )
@@ -396,7 +460,7 @@ void Chip8_Debugger::Update( const double* time )
 
 				if( m_bFollowPc )
 				{
-					std::vector<uint16_t>::iterator it = std::lower_bound( m_aAdress.begin(),m_aAdress.end(),m_pCPU->GetPC() );
+					std::vector<uint16_t>::iterator it = std::lower_bound( m_aAdress.begin(),m_aAdress.end(),m_pSnapshot->iPC );
 					if( it != m_aAdress.end() )
 					{
 						int iIndex = std::distance( m_aAdress.begin(),it );
@@ -419,7 +483,7 @@ void Chip8_Debugger::Update( const double* time )
 						ImGui::PushID( n );
 
 						const auto&[m_iAddress, m_sText] = aDisassemblyInstructions.at( m_aAdress[ n ] );
-						bool isCurrent = m_iAddress == m_pCPU->GetPC();
+						bool isCurrent = m_iAddress == m_pSnapshot->iPC;
 
 						if( isCurrent )
 							ImGui::PushStyleColor( ImGuiCol_Text,ImVec4( 1,1,0,1 ) );
@@ -460,22 +524,47 @@ void Chip8_Debugger::Destroy()
 	delete m_pSingleton;
 }
 
+void Chip8_Debugger::_TakeSnapshot( StateSnapshot& oSnapshot ) const
+{
+	//Bytes past a 4K address space are already at 0 in the machine snapshot
+	oSnapshot.aMemory = m_pSnapshot->aMemory;
+
+	for( int i = 0; i < 0x10; ++i )
+	{
+		oSnapshot.aRegisters[ i ] = m_pSnapshot->aRegisters[ i ];
+		oSnapshot.aStack[ i ] = m_pSnapshot->aStack[ i ];
+	}
+	oSnapshot.aRegisters[ 16 ] = m_pSnapshot->iI;
+	oSnapshot.aRegisters[ 17 ] = m_pSnapshot->iSP;
+	oSnapshot.aRegisters[ 18 ] = m_pSnapshot->iPC;
+	oSnapshot.aRegisters[ 19 ] = m_pSnapshot->iDelayTimer;
+	oSnapshot.aRegisters[ 20 ] = m_pSnapshot->iSoundTimer;
+}
+
+//Once per emulated frame, not per write : the CPU never pays for the highlighting
+void Chip8_Debugger::_TrackChanges()
+{
+	if( m_iCycleIndex == m_pSnapshot->iCycle )
+		return;
+
+	m_oPreviousState = m_oLastState;
+	_TakeSnapshot( m_oLastState );
+	m_iCycleIndex = m_pSnapshot->iCycle;
+}
+
 template< typename T >
-void Chip8_Debugger::FormatDebugData( std::string sText,const char* sFormat,const T& oData,int& iIndexSelectable,int& iIndexPosition )
+void Chip8_Debugger::FormatDebugData( std::string sText,const char* sFormat,const T& oData,const uint16_t iPreviousValue,int& iIndexSelectable,int& iIndexPosition )
 {
 #ifdef DEBUG_INFO
 	static_assert( std::is_same_v<T,Data<uint8_t>> || std::is_same_v<T,Data<uint16_t>>,"Function is being call with an unsupported type" );
 
-	if( m_iCycleIndex != m_pCPU->GetCycleId() )
-		oData.SetDataAsDirty();
-
 	ImGui::PushID( iIndexPosition );
 	if( !sText.empty() )
 	{
 		ImGui::Text( "%s", sText.c_str() );
 		ImGui::SameLine();
 	}
-	ImGui::PushStyleColor( ImGuiCol_Text,oData.IsNULL() ? NULL_DATA_COLOR : oData.HasChanged() ? CHANGE_DATA_COLOR : DEFAULT_DATA_COLOR );
+	ImGui::PushStyleColor( ImGuiCol_Text,oData.IsNULL() ? NULL_DATA_COLOR : oData != iPreviousValue ? CHANGE_DATA_COLOR : DEFAULT_DATA_COLOR );
 
 	char buffer[ 64 ];
 	if constexpr( std::is_same_v<T,Data<uint8_t>> )
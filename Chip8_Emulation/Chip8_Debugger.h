@@ -2,16 +2,21 @@
 #include "string"
 #include <sstream>
 #include <chrono>
+#include <array>
+#include <cstdint>
 
-class Chip8;
+class EmulationThread;
+struct MachineSnapshot;
+struct LoadedRom;
 class Chip8_Debugger
 {
 public:
 	Chip8_Debugger();
 	~Chip8_Debugger();
 
-	void Init( GLFWwindow* mainWindow,const Chip8* pCPU );
-	void Update( const double* time );
+	void Init( GLFWwindow* mainWindow,EmulationThread* pEmulation );
+	//Shows the snapshot, every change goes back as a command : the machine may be running on another thread
+	void Update( const double* time,const MachineSnapshot& oSnapshot );
 	void Render();
 	void Destroy();
 
@@ -23,14 +28,31 @@ public:
 	}
 
 private:
+	//Guest values as they were on a displayed frame
+	struct StateSnapshot
+	{
+		std::array< uint8_t,0x10000 >	aMemory = {};
+		std::array< uint16_t,21 >		aRegisters = {}; //V0 - VF, I, SP, PC, DT, ST : CPU window order
+		std::array< uint16_t,16 >		aStack = {};
+	};
+
+	void _TakeSnapshot( StateSnapshot& oSnapshot ) const;
+	void _TrackChanges();
+
 	template< typename T >
-	void FormatDebugData( std::string sText,const char* sFormat, const T& oData, int& iIndexSelectable, int& iIndexPosition );
+	void FormatDebugData( std::string sText,const char* sFormat, const T& oData,const uint16_t iPreviousValue, int& iIndexSelectable, int& iIndexPosition );
 
 	static Chip8_Debugger*		m_pSingleton;
 
 	GLFWwindow*					m_pWindow;
-	const Chip8*				m_pCPU;
-	int							m_iCycleIndex;
+	EmulationThread*			m_pEmulation;
+	const MachineSnapshot*		m_pSnapshot; //Valid during Update only
+	const LoadedRom*			m_pDisassembledRom; //ROM the addresses of the disassembly window come from
+	long long unsigned			m_iCycleIndex; //Cycle of m_oLastState
+
+	//Nothing is tracked on the write path : a value is shown as changed when it differs from the frame before the last one emulated
+	StateSnapshot				m_oPreviousState;
+	StateSnapshot				m_oLastState;
 
 	int							m_iRegisterSelected;
 	int							m_iMemorySelected;
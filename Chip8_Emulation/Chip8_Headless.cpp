@@ -0,0 +1,279 @@
+#include "Chip8.h"
+#include "MachinePool.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+//Headless runner : no window, no audio device, the CPU runs frame after frame as fast as the host allows
+#define DEFAULT_FRAMES_TO_RUN 600
+#define DEFAULT_RANDOM_SEED 0xC8C8C8C8 //Runs are reproducible unless --seed clock is given
+
+struct RunResult
+{
+	long long						iFrames = 0;
+	long long unsigned				iInstructions = 0;
+	DecodeCacheStats				oDecodeCache;
+	BlockCacheStats					oBlockCache;
+	IdleLoopStats					oIdleLoops;
+	std::string						sDivergence; //Filled by --verify on the first frame the reference disagrees
+};
+
+//Whole guest state, registers, memory and screen
+static std::string CompareStates( const Chip8& oCpu,const Chip8& oReference )
+{
+	for( int i = 0; i < 16; ++i )
+	{
+		if( oCpu.GetRegisters()[ i ] != oReference.GetRegisters()[ i ] )
+			return "V" + std::to_string( i );
+		if( oCpu.GetStack()[ i ] != oReference.GetStack()[ i ] )
+			return "Stack " + std::to_string( i );
+	}
+	if( oCpu.GetI() != oReference.GetI() )
+		return "I";
+	if( oCpu.GetPC() != oReference.GetPC() )
+		return "PC";
+	if( oCpu.GetSP() != oReference.GetSP() )
+		return "SP";
+	if( oCpu.GetDelayTimer() != oReference.GetDelayTimer() || oCpu.GetSoundTimer() != oReference.GetSoundTimer() )
+		return "Timers";
+	if( oCpu.GetCycleId() != oReference.GetCycleId() )
+		return "Cycle count";
+	if( oCpu.GetMemorySize() != oReference.GetMemorySize() )
+		return "Memory size";
+	for( uint32_t i = 0; i < oCpu.GetMemorySize(); ++i )
+	{
+		if( oCpu.GetMemoryAtAddr( i ) != oReference.GetMemoryAtAddr( i ) )
+			return "Memory " + std::to_string( i );
+	}
+	const uint64_t* pPixels = oCpu.GetFrameBuffer().GetPixels();
+	const uint64_t* pReferencePixels = oReference.GetFrameBuffer().GetPixels();
+	for( int i = 0; i < 2 * 64 * 2; ++i )
+	{
+		if( pPixels[ i ] != pReferencePixels[ i ] )
+			return "Screen";
+	}
+	return std::string();
+}
+
+//Every machine is independent, a thread only runs the slice of machines it has been given
+static void RunMachines( const Chip8::KeyAccess& oKey,std::vector< Chip8* >& aMachines,std::vector< std::unique_ptr< Chip8 > >& aReferences,std::vector< RunResult >& aResults,const size_t iBegin,const size_t iEnd,const long long iFramesToRun )
+{
+	for( size_t iMachine = iBegin; iMachine < iEnd; ++iMachine )
+	{
+		Chip8* pCpu = aMachines[ iMachine ];
+		Chip8* pReference = aReferences.empty() ? nullptr : aReferences[ iMachine ].get();
+		long long iFrame = 0;
+		for( ; iFrame < iFramesToRun; ++iFrame )
+		{
+			pCpu->EmulateCycle( oKey );
+			if( pReference != nullptr )
+			{
+				pReference->EmulateCycle( oKey );
+				std::string sDiff = CompareStates( *pCpu,*pReference );
+				if( !sDiff.empty() )
+				{
+					aResults[ iMachine ].sDivergence = "frame " + std::to_string( iFrame ) + ", " + sDiff;
+					++iFrame;
+					break;
+				}
+			}
+
+			if( !pCpu->IsRunning() ) //End of program reached ( self jump or EXIT )
+			{
+				++iFrame;
+				break;
+			}
+		}
+		aResults[ iMachine ].iFrames = iFrame;
+		aResults[ iMachine ].iInstructions = pCpu->GetInstructionsRun();
+		aResults[ iMachine ].oDecodeCache = pCpu->GetDecodeCacheStats();
+		aResults[ iMachine ].oBlockCache = pCpu->GetBlockCacheStats();
+		aResults[ iMachine ].oIdleLoops = pCpu->GetIdleLoopStats();
+	}
+}
+
+int main( int argc,char* argv[] )
+{
+	if( argc < 2 )
+	{
+		std::cerr << "Usage: " << argv[ 0 ] << " <rom> [frames] [--instances N] [--threads T] [--dispatch switch|predecode|table|threaded] [--engine interpreter|blocks|jit|aot] [--verify] [--huge-pages] [--seed N|clock] [--governor]" << std::endl;
+		return -1;
+	}
+
+	const char* sROMToLoad = argv[ 1 ];
+	long long iFramesToRun = DEFAULT_FRAMES_TO_RUN;
+	int iInstances = 1;
+	int iThreads = 1;
+	InterpreterDispatch oDispatch = InterpreterDispatch::PredecodeCache;
+	ExecutionEngine oEngine = ExecutionEngine::Interpreter;
+	bool bVerify = false;
+	bool bHugePages = false;
+	bool bGovernor = false;
+	bool bClockSeed = false;
+	uint32_t iSeed = DEFAULT_RANDOM_SEED;
+	for( int i = 2; i < argc; ++i )
+	{
+		std::string sArg = argv[ i ];
+		if( sArg == "--instances" && i + 1 < argc )
+			iInstances = std::max( 1,std::stoi( argv[ ++i ] ) );
+		else if( sArg == "--threads" && i + 1 < argc )
+			iThreads = std::max( 1,std::stoi( argv[ ++i ] ) );
+		else if( sArg == "--verify" )
+			bVerify = true;
+		else if( sArg == "--huge-pages" )
+			bHugePages = true;
+		else if( sArg == "--governor" )
+			bGovernor = true;
+		else if( sArg == "--seed" && i + 1 < argc )
+		{
+			std::string sSeed = argv[ ++i ];
+			if( sSeed == "clock" )
+				bClockSeed = true;
+			else
+				iSeed = static_cast< uint32_t >( std::stoul( sSeed,nullptr,0 ) );
+		}
+		else if( sArg == "--dispatch" && i + 1 < argc )
+		{
+			std::string sDispatch = argv[ ++i ];
+			if( sDispatch == "switch" )
+				oDispatch = InterpreterDispatch::Switch;
+			else if( sDispatch == "table" )
+				oDispatch = InterpreterDispatch::OpcodeTable;
+			else if( sDispatch == "threaded" )
+				oDispatch = InterpreterDispatch::Threaded;
+			else if( sDispatch != "predecode" )
+			{
+				std::cerr << "ERROR::HEADLESS::UNKNOWN_DISPATCH " << sDispatch << std::endl;
+				return -1;
+			}
+		}
+		else if( sArg == "--engine" && i + 1 < argc )
+		{
+			std::string sEngine = argv[ ++i ];
+			if( sEngine == "blocks" )
+				oEngine = ExecutionEngine::BasicBlocks;
+			else if( sEngine == "jit" )
+				oEngine = ExecutionEngine::Jit;
+			else if( sEngine == "aot" )
+				oEngine = ExecutionEngine::Aot;
+			else if( sEngine != "interpreter" )
+			{
+				std::cerr << "ERROR::HEADLESS::UNKNOWN_ENGINE " << sEngine << std::endl;
+				return -1;
+			}
+		}
+		else
+			iFramesToRun = std::stoll( sArg );
+	}
+	iThreads = std::min( iThreads,iInstances );
+
+	Chip8::KeyAccess oKey;
+	MachinePool oPool( iInstances,bHugePages );
+	std::vector< Chip8* > aMachines;
+	std::vector< std::unique_ptr< Chip8 > > aReferences; //--verify : plain switch interpreter run in lockstep
+	for( int i = 0; i < iInstances; ++i )
+	{
+		//One stream per machine, the reference replays the stream of its machine
+		const uint32_t iMachineSeed = bClockSeed ? static_cast< uint32_t >( std::chrono::steady_clock::now().time_since_epoch().count() ) : iSeed + i;
+		if( bVerify )
+		{
+			std::unique_ptr< Chip8 > pReference = std::make_unique< Chip8 >();
+			pReference->Init( oKey,sROMToLoad );
+			pReference->SetInterpreterDispatch( InterpreterDispatch::Switch );
+			pReference->SetRandomSeed( iMachineSeed );
+			pReference->SetIpfGovernor( bGovernor );
+			pReference->AskForState( oKey,RunningState::Running );
+			aReferences.push_back( std::move( pReference ) );
+		}
+
+		Chip8* pCpu = oPool.Acquire( oKey,sROMToLoad );
+		if( pCpu == nullptr )
+			return -1;
+
+		pCpu->SetInterpreterDispatch( oDispatch );
+		pCpu->SetExecutionEngine( oEngine );
+		pCpu->SetRandomSeed( iMachineSeed );
+		pCpu->SetIpfGovernor( bGovernor );
+		pCpu->AskForState( oKey,RunningState::Running );
+		aMachines.push_back( pCpu );
+	}
+
+	std::vector< RunResult > aResults( iInstances );
+	std::vector< std::thread > aThreads;
+	size_t iSlice = ( aMachines.size() + iThreads - 1 ) / iThreads;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for( int iThread = 0; iThread < iThreads; ++iThread )
+	{
+		size_t iBegin = iThread * iSlice;
+		size_t iEnd = std::min( aMachines.size(),iBegin + iSlice );
+		aThreads.emplace_back( RunMachines,std::cref( oKey ),std::ref( aMachines ),std::ref( aReferences ),std::ref( aResults ),iBegin,iEnd,iFramesToRun );
+	}
+	for( std::thread& oThread : aThreads )
+		oThread.join();
+	double fElapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+	long long iFrame = 0;
+	long long unsigned iInstructions = 0;
+	DecodeCacheStats oDecodeCache;
+	BlockCacheStats oBlockCache;
+	IdleLoopStats oIdleLoops;
+	for( const RunResult& oResult : aResults )
+	{
+		iFrame += oResult.iFrames;
+		iInstructions += oResult.iInstructions;
+		oDecodeCache.iHits += oResult.oDecodeCache.iHits;
+		oDecodeCache.iMisses += oResult.oDecodeCache.iMisses;
+		oDecodeCache.iInvalidations += oResult.oDecodeCache.iInvalidations;
+		oBlockCache.iBlocksTranslated += oResult.oBlockCache.iBlocksTranslated;
+		oBlockCache.iBlocksRun += oResult.oBlockCache.iBlocksRun;
+		oBlockCache.iChainedRuns += oResult.oBlockCache.iChainedRuns;
+		oBlockCache.iInvalidations += oResult.oBlockCache.iInvalidations;
+		oBlockCache.iAotBlocks += oResult.oBlockCache.iAotBlocks;
+		oIdleLoops.iSkips += oResult.oIdleLoops.iSkips;
+		oIdleLoops.iSkippedCycles += oResult.oIdleLoops.iSkippedCycles;
+	}
+
+	std::cout << "ROM           : " << sROMToLoad << std::endl;
+	std::cout << "Machines      : " << iInstances << " on " << iThreads << " thread(s), " << oPool.GetRegionSize() / 1024 << " KB pool" << ( oPool.IsHugePageBacked() ? " on huge pages" : "" ) << std::endl;
+	std::cout << "Random seed   : " << ( bClockSeed ? std::string( "clock" ) : std::to_string( iSeed ) + ( iInstances > 1 ? " + machine index" : "" ) ) << std::endl;
+	std::cout << "Frames        : " << iFrame << " ( " << aMachines[ 0 ]->GetInstructPerFrame() << " IPF" << ( bGovernor ? ", governed up to " + std::to_string( aMachines[ 0 ]->GetMaxInstructPerFrame() ) : std::string() ) << " )" << std::endl;
+	std::cout << "Instructions  : " << iInstructions << std::endl;
+	std::cout << "Idle loops    : " << oIdleLoops.iSkippedCycles << " cycles skipped in " << oIdleLoops.iSkips << " jumps" << std::endl;
+	if( oEngine != ExecutionEngine::Interpreter )
+		std::cout << "Blocks        : " << oBlockCache.iBlocksTranslated << " translated, " << oBlockCache.iBlocksRun << " run ( " << oBlockCache.iChainedRuns << " chained ), " << oBlockCache.iInvalidations << " invalidations" << std::endl;
+	if( oEngine == ExecutionEngine::Aot )
+	{
+		if( aMachines[ 0 ]->HasAotModule() )
+			std::cout << "AOT           : " << oBlockCache.iAotBlocks << " blocks bound to generated code" << std::endl;
+		else
+			std::cout << "AOT           : no module linked for this ROM, blocks are interpreted" << std::endl;
+	}
+	if( oDispatch == InterpreterDispatch::PredecodeCache )
+		std::cout << "Predecode     : " << oDecodeCache.iHits << " hits, " << oDecodeCache.iMisses << " misses, " << oDecodeCache.iInvalidations << " invalidations" << std::endl;
+	if( bVerify )
+	{
+		int iDiverging = 0;
+		for( size_t i = 0; i < aResults.size(); ++i )
+		{
+			if( aResults[ i ].sDivergence.empty() )
+				continue;
+			std::cout << "Verify        : machine " << i << " diverges from the switch interpreter at " << aResults[ i ].sDivergence << std::endl;
+			++iDiverging;
+		}
+		if( iDiverging == 0 )
+			std::cout << "Verify        : identical to the switch interpreter" << std::endl;
+	}
+	std::cout << "Elapsed       : " << fElapsed << " s" << std::endl;
+	if( fElapsed > 0.0 )
+	{
+		std::cout << "Frames/s      : " << iFrame / fElapsed << std::endl;
+		std::cout << "Instructions/s: " << iInstructions / fElapsed << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,345 @@
+#include "AotRuntime.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+
+//Ahead-of-time recompiler : turns the reachable code of a ROM into a C++ translation unit the runners link as a fast path
+//Blocks are cut exactly like the runtime translation does, the CPU binds them when it translates the same opcodes
+#define DEFAULT_AOT_FOLDER "../Aot/"
+
+using namespace MemoryMap;
+
+static std::string Hex( const uint32_t iValue,const int iWidth )
+{
+	std::stringstream sstream;
+	sstream << "0x" << std::uppercase << std::hex << std::setw( iWidth ) << std::setfill( '0' ) << iValue;
+	return sstream.str();
+}
+
+static uint16_t ReadOpcode( const Chip8& oCpu,const uint32_t iAddr )
+{
+	if( iAddr + 1 >= oCpu.GetMemorySize() )
+		return 0;
+	return oCpu.GetMemoryAtAddr( iAddr ) << 8 | oCpu.GetMemoryAtAddr( iAddr + 1 );
+}
+
+//Every address the CPU can start a block at while running the code found by the disassembler walk
+static std::set< uint16_t > CollectBlockStarts( const Chip8& oCpu,const Disassembler& oWalk,const bool bAllEntries )
+{
+	std::set< uint16_t > aStarts = { START_ROM_MEMORY_ADDRESS };
+	for( const auto& oLine : oWalk.GetDisassemblyInstructions() )
+	{
+		const uint16_t iAddr = oLine.first;
+		const uint16_t iOpcode = ReadOpcode( oCpu,iAddr );
+		if( bAllEntries ) //A frame can end anywhere, the next one then starts a block in the middle of another
+			aStarts.insert( iAddr );
+
+		if( AotRuntime::IsSkipOpcode( iOpcode ) )
+		{
+			aStarts.insert( iAddr + 2 );
+			aStarts.insert( iAddr + ( ReadOpcode( oCpu,iAddr + 2 ) == 0xF000 ? 6 : 4 ) );
+			continue;
+		}
+
+		switch( iOpcode & 0xF000 )
+		{
+		case 0x1000: aStarts.insert( iOpcode & 0x0FFF ); break;
+		case 0x2000: aStarts.insert( iOpcode & 0x0FFF ); aStarts.insert( iAddr + 2 ); break;
+		case 0xB000: aStarts.insert( iOpcode & 0x0FFF ); break; //Offset unknown, V0 == 0 is the common case
+		case 0xD000: aStarts.insert( iAddr + 2 ); break;
+		case 0x5000: aStarts.insert( iAddr + 2 ); break; //SAVE range store
+		case 0xF000: aStarts.insert( iAddr + ( iOpcode == 0xF000 ? 4 : 2 ) ); break; //Key wait, BCD, stores
+		default: break;
+		}
+	}
+	return aStarts;
+}
+
+//Tracks what the generated function touches so only the needed references are declared
+struct BlockBody
+{
+	std::stringstream				sCode;
+	bool							bRegisters = false;
+	bool							bStack = false;
+	bool							bI = false;
+	bool							bPC = false;
+};
+
+//Returns false when the opcode is left to the interpreter handler
+static bool EmitNativeOpcode( BlockBody& oBody,const uint16_t iOpcode,const uint16_t iAddr,const uint16_t iFollowingOpcode,const Quirk& oQuirk )
+{
+	const std::string X = std::to_string( ( iOpcode & 0x0F00 ) >> 8 );
+	const std::string Y = std::to_string( ( iOpcode & 0x00F0 ) >> 4 );
+	const std::string NN = Hex( iOpcode & 0x00FF,2 );
+	const std::string NNN = Hex( iOpcode & 0x0FFF,3 );
+	const std::string sNext = Hex( iAddr + 2,4 );
+	const std::string sSkipped = Hex( iAddr + ( iFollowingOpcode == 0xF000 ? 6 : 4 ),4 );
+	std::stringstream& s = oBody.sCode;
+
+	auto Skip = [ & ]( const std::string& sCondition )
+	{
+		oBody.bPC = true;
+		s << "\tif( " << sCondition << " )\n\t\tPC = " << sSkipped << ";\n\telse\n\t\tPC = " << sNext << ";\n";
+	};
+
+	switch( iOpcode & 0xF000 )
+	{
+	case 0x0000:
+		if( ( iOpcode & 0x00FF ) != 0xEE )
+			return false;
+		oBody.bPC = oBody.bStack = true;
+		s << "\tPC = aStack[ SP ];\n\taStack[ SP ] = 0;\n\tif( SP != 0 )\n\t\t--SP;\n";
+		return true;
+	case 0x1000:
+		oBody.bPC = true;
+		s << "\tPC = " << NNN << ";\n";
+		return true;
+	case 0x2000:
+		oBody.bPC = oBody.bStack = true;
+		s << "\tif( aStack[ 0 ] != 0 )\n\t\t++SP;\n\taStack[ SP ] = " << sNext << ";\n\tPC = " << NNN << ";\n";
+		return true;
+	case 0x3000: oBody.bRegisters = true; Skip( "V[ " + X + " ] == " + NN ); return true;
+	case 0x4000: oBody.bRegisters = true; Skip( "V[ " + X + " ] != " + NN ); return true;
+	case 0x5000:
+		if( ( iOpcode & 0x000F ) != 0 )
+			return false;
+		oBody.bRegisters = true;
+		Skip( "V[ " + X + " ] == V[ " + Y + " ]" );
+		return true;
+	case 0x6000: oBody.bRegisters = true; s << "\tV[ " << X << " ] = " << NN << ";\n"; return true;
+	case 0x7000: oBody.bRegisters = true; s << "\tV[ " << X << " ] += " << NN << ";\n"; return true;
+	case 0x8000:
+	{
+		oBody.bRegisters = true;
+		const std::string sVFReset = oQuirk.bVFResetFlag ? "\tV[ 15 ] = 0;\n" : "";
+		switch( iOpcode & 0x000F )
+		{
+		case 0x0: s << "\tV[ " << X << " ] = V[ " << Y << " ];\n"; return true;
+		case 0x1: s << "\tV[ " << X << " ] |= V[ " << Y << " ];\n" << sVFReset; return true;
+		case 0x2: s << "\tV[ " << X << " ] &= V[ " << Y << " ];\n" << sVFReset; return true;
+		case 0x3: s << "\tV[ " << X << " ] ^= V[ " << Y << " ];\n" << sVFReset; return true;
+		case 0x4: s << "\t{\n\t\tuint16_t iSum = V[ " << X << " ] + V[ " << Y << " ];\n\t\tV[ " << X << " ] = iSum & 0xFF;\n\t\tV[ 15 ] = ( iSum > 0xFF ) ? 1 : 0;\n\t}\n"; return true;
+		case 0x5: s << "\t{\n\t\tuint16_t iDiff = V[ " << X << " ] - V[ " << Y << " ];\n\t\tV[ " << X << " ] = iDiff & 0xFF;\n\t\tV[ 15 ] = iDiff > 0xFF ? 0 : 1;\n\t}\n"; return true;
+		case 0x7: s << "\t{\n\t\tuint8_t vx = V[ " << X << " ];\n\t\tuint8_t vy = V[ " << Y << " ];\n\t\tV[ " << X << " ] = ( vy - vx ) & 0xFF;\n\t\tV[ 15 ] = vy >= vx ? 1 : 0;\n\t}\n"; return true;
+		case 0x6:
+			if( !oQuirk.bShiftingFlag )
+				s << "\t{\n\t\tuint8_t LSB = V[ " << Y << " ] & 0x01;\n\t\tV[ " << X << " ] = V[ " << Y << " ] >> 1;\n\t\tV[ 15 ] = LSB;\n\t}\n";
+			else
+				s << "\t{\n\t\tuint8_t LSB = V[ " << X << " ] & 0x01;\n\t\tV[ " << X << " ] >>= 1;\n\t\tV[ 15 ] = LSB;\n\t}\n";
+			return true;
+		case 0xE:
+			if( !oQuirk.bShiftingFlag )
+				s << "\t{\n\t\tuint8_t MSB = ( V[ " << Y << " ] & 0x80 ) == 0x80 ? 1 : 0;\n\t\tV[ " << X << " ] = V[ " << Y << " ] << 1;\n\t\tV[ 15 ] = MSB;\n\t}\n";
+			else
+				s << "\t{\n\t\tuint8_t MSB = ( V[ " << X << " ] & 0x80 ) == 0x80 ? 1 : 0;\n\t\tV[ " << X << " ] <<= 1;\n\t\tV[ 15 ] = MSB;\n\t}\n";
+			return true;
+		default: return false;
+		}
+	}
+	case 0x9000: oBody.bRegisters = true; Skip( "V[ " + X + " ] != V[ " + Y + " ]" ); return true;
+	case 0xA000: oBody.bI = true; s << "\tI = " << NNN << ";\n"; return true;
+	case 0xB000:
+		oBody.bPC = oBody.bRegisters = true;
+		s << "\tPC = " << NNN << " + V[ " << ( oQuirk.bQuirkJumpingFlag ? X : "0" ) << " ];\n";
+		return true;
+	case 0xE000:
+		oBody.bRegisters = true;
+		if( ( iOpcode & 0x00FF ) == 0x9E )
+			Skip( "pCpu->GetKeyState( V[ " + X + " ] )" );
+		else if( ( iOpcode & 0x00FF ) == 0xA1 )
+			Skip( "!pCpu->GetKeyState( V[ " + X + " ] )" );
+		else
+			return false;
+		return true;
+	case 0xF000:
+		switch( iOpcode & 0xF0FF )
+		{
+		case 0xF007: oBody.bRegisters = true; s << "\tV[ " << X << " ] = AotRuntime::GetDelayTimer( pCpu );\n"; return true;
+		case 0xF015: oBody.bRegisters = true; s << "\tAotRuntime::GetDelayTimer( pCpu ) = V[ " << X << " ];\n"; return true;
+		case 0xF018: oBody.bRegisters = true; s << "\tAotRuntime::GetSoundTimer( pCpu ) = V[ " << X << " ];\n"; return true;
+		case 0xF01E: oBody.bRegisters = oBody.bI = true; s << "\tI += V[ " << X << " ];\n"; return true;
+		case 0xF029: oBody.bRegisters = oBody.bI = true; s << "\tI = MemoryMap::START_FONT_MEMORY_ADDRESS + ( ( V[ " << X << " ] & 0xF ) * 5 );\n"; return true;
+		case 0xF030: oBody.bRegisters = oBody.bI = true; s << "\tI = MemoryMap::START_sFONT_MEMORY_ADDRESS + ( ( V[ " << X << " ] & 0xF ) * 10 );\n"; return true;
+		default: return false; //LD I, NNNN included : its operand is read from memory which isn't part of the opcodes checked on bind
+		}
+	default: return false; //RND, DRAW
+	}
+}
+
+static bool IsControlFlow( const uint16_t iOpcode )
+{
+	switch( iOpcode & 0xF000 )
+	{
+	case 0x0000: return ( iOpcode & 0x00FF ) == 0xEE;
+	case 0x1000:
+	case 0x2000:
+	case 0xB000: return true;
+	default: return AotRuntime::IsSkipOpcode( iOpcode );
+	}
+}
+
+//Same effect as running the opcodes one by one through the interpreter, PC is only written when someone can see it
+static std::string EmitBlock( const uint16_t iStartPC,const std::vector< uint16_t >& aOpcodes,const uint16_t iFollowingOpcode,const Quirk& oQuirk )
+{
+	BlockBody oBody;
+	uint32_t iAddr = iStartPC;
+	uint32_t iPCInMemory = iStartPC;
+	bool bPCHandled = false; //Set by the last opcode itself ( jump, skip, or interpreter handler which may rewind it )
+	bool bLastIsNative = false;
+
+	for( size_t i = 0; i < aOpcodes.size(); ++i )
+	{
+		const uint16_t iOpcode = aOpcodes[ i ];
+		const bool bLast = i + 1 == aOpcodes.size();
+		oBody.sCode << "\t//" << Hex( iAddr,4 ) << " " << Hex( iOpcode,4 ) << "\n";
+
+		bLastIsNative = EmitNativeOpcode( oBody,iOpcode,iAddr,bLast ? iFollowingOpcode : 0,oQuirk );
+		if( bLastIsNative )
+			bPCHandled = IsControlFlow( iOpcode );
+		else
+		{
+			if( iPCInMemory != iAddr )
+			{
+				oBody.bPC = true;
+				oBody.sCode << "\tPC = " << Hex( iAddr,4 ) << ";\n";
+			}
+			oBody.sCode << "\tAotRuntime::Execute( pCpu," << Hex( iOpcode,4 ) << " );\n";
+			iPCInMemory = iAddr + ( iOpcode == 0xF000 ? 4 : 2 );
+			bPCHandled = bLast;
+		}
+		iAddr += iOpcode == 0xF000 ? 4 : 2;
+	}
+
+	if( !bPCHandled && iPCInMemory != iAddr )
+	{
+		oBody.bPC = true;
+		oBody.sCode << "\tPC = " << Hex( iAddr,4 ) << ";\n";
+	}
+	if( bLastIsNative )
+		oBody.sCode << "\tAotRuntime::SetCurrentOpcode( pCpu," << Hex( aOpcodes.back(),4 ) << " );\n";
+
+	std::stringstream sFunction;
+	sFunction << "void Block_" << Hex( iStartPC,4 ).substr( 2 ) << "( Chip8* pCpu )\n{\n";
+	if( oBody.bRegisters )
+		sFunction << "\tData< uint8_t >* V = AotRuntime::GetRegisters( pCpu );\n";
+	if( oBody.bStack )
+		sFunction << "\tData< uint16_t >* aStack = AotRuntime::GetStack( pCpu );\n\tData< uint8_t >& SP = AotRuntime::GetSP( pCpu );\n";
+	if( oBody.bI )
+		sFunction << "\tData< uint16_t >& I = AotRuntime::GetI( pCpu );\n";
+	if( oBody.bPC )
+		sFunction << "\tData< uint16_t >& PC = AotRuntime::GetPC( pCpu );\n";
+	sFunction << oBody.sCode.str() << "}\n\n";
+	return sFunction.str();
+}
+
+int main( int argc,char* argv[] )
+{
+	if( argc < 2 )
+	{
+		std::cerr << "Usage: " << argv[ 0 ] << " <rom> [output.cpp] [--all-entries]" << std::endl;
+		return -1;
+	}
+
+	const char* sROMToLoad = argv[ 1 ];
+	std::filesystem::path outputPath = std::filesystem::path( DEFAULT_AOT_FOLDER ) / std::filesystem::path( sROMToLoad ).filename();
+	outputPath.replace_extension( ".cpp" );
+	bool bAllEntries = false;
+	for( int i = 2; i < argc; ++i )
+	{
+		std::string sArg = argv[ i ];
+		if( sArg == "--all-entries" )
+			bAllEntries = true;
+		else
+			outputPath = sArg;
+	}
+
+	Chip8::KeyAccess oKey;
+	Chip8 oCpu;
+	oCpu.Init( oKey,sROMToLoad );
+	if( oCpu.GetCurrentRomLoaded() == nullptr )
+		return -1;
+
+	Disassembler oWalk;
+	oWalk.Disassemble_ROM( sROMToLoad,oCpu );
+
+	const Quirk& oQuirk = oCpu.m_oCurrentQuirk;
+	std::set< uint16_t > aStarts = CollectBlockStarts( oCpu,oWalk,bAllEntries );
+	std::vector< uint16_t > aWorklist( aStarts.begin(),aStarts.end() );
+
+	std::map< uint16_t,std::string > aFunctions; //Sorted by address, the module table has to be
+	while( !aWorklist.empty() )
+	{
+		const uint16_t iStartPC = aWorklist.back();
+		aWorklist.pop_back();
+		if( aFunctions.count( iStartPC ) != 0 || static_cast< uint32_t >( iStartPC ) + 1 >= oCpu.GetMemorySize() )
+			continue;
+
+		std::vector< uint16_t > aOpcodes;
+		uint16_t iFollowingOpcode = 0;
+		uint32_t iEndPC = AotRuntime::ScanBlock( oCpu,iStartPC,aOpcodes,iFollowingOpcode );
+		if( aOpcodes.empty() )
+			continue;
+
+		aFunctions[ iStartPC ] = EmitBlock( iStartPC,aOpcodes,iFollowingOpcode,oQuirk );
+		//Straight-line code cut on the length limit or after a DRAW / store goes on in the next block
+		if( !IsControlFlow( aOpcodes.back() ) && iEndPC + 1 < oCpu.GetMemorySize() && aFunctions.count( iEndPC ) == 0 )
+			aWorklist.push_back( iEndPC );
+	}
+
+	std::string sRomName = std::filesystem::path( sROMToLoad ).filename().string();
+	std::ofstream file( outputPath );
+	if( !file.is_open() )
+	{
+		std::cerr << "ERROR::RECOMPILER::CANT_OPEN_FILE " << outputPath << std::endl;
+		return -1;
+	}
+
+	file << "//Generated by Chip8_Recompiler from " << sRomName << ", do not edit\n";
+	file << "#include \"AotRuntime.h\"\n\n";
+	file << "namespace\n{\n\n";
+	for( const auto& oFunction : aFunctions )
+		file << oFunction.second;
+
+	std::stringstream sTable;
+	for( const auto& oFunction : aFunctions )
+	{
+		const uint16_t iStartPC = oFunction.first;
+		std::vector< uint16_t > aOpcodes;
+		uint16_t iFollowingOpcode = 0;
+		AotRuntime::ScanBlock( oCpu,iStartPC,aOpcodes,iFollowingOpcode );
+
+		std::string sSuffix = Hex( iStartPC,4 ).substr( 2 );
+		file << "const uint16_t s_aOpcodes_" << sSuffix << "[] = {";
+		for( size_t i = 0; i < aOpcodes.size(); ++i )
+			file << ( i == 0 ? " " : "," ) << Hex( aOpcodes[ i ],4 );
+		file << " };\n";
+		sTable << "\t{ " << Hex( iStartPC,4 ) << "," << aOpcodes.size() << ",s_aOpcodes_" << sSuffix << "," << Hex( iFollowingOpcode,4 ) << ",&Block_" << sSuffix << " },\n";
+	}
+
+	file << "\nconst AotBlock s_aBlocks[] =\n{\n" << sTable.str() << "};\n\n";
+	file << "Quirk CompiledQuirk()\n{\n\tQuirk oQuirk;\n" << std::boolalpha;
+	file << "\toQuirk.bVFResetFlag = " << oQuirk.bVFResetFlag << ";\n";
+	file << "\toQuirk.bMemoryUnchanged = " << oQuirk.bMemoryUnchanged << ";\n";
+	file << "\toQuirk.bMemoryIncrementByX = " << oQuirk.bMemoryIncrementByX << ";\n";
+	file << "\toQuirk.bDispWaitFlag = " << oQuirk.bDispWaitFlag << ";\n";
+	file << "\toQuirk.bWrapFlag = " << oQuirk.bWrapFlag << ";\n";
+	file << "\toQuirk.bShiftingFlag = " << oQuirk.bShiftingFlag << ";\n";
+	file << "\toQuirk.bQuirkJumpingFlag = " << oQuirk.bQuirkJumpingFlag << ";\n";
+	file << "\toQuirk.bLegacySrolling = " << oQuirk.bLegacySrolling << ";\n";
+	file << "\treturn oQuirk;\n}\n\n";
+	file << "const AotModule s_oModule = { \"" << sRomName << "\",\"" << oCpu.GetRomSettings().sHash << "\",CompiledQuirk(),s_aBlocks," << aFunctions.size() << " };\n";
+	file << "AotRegistrar s_oRegistrar( s_oModule );\n\n";
+	file << "}\n";
+
+	std::cout << "ROM           : " << sRomName << std::endl;
+	std::cout << "Reachable     : " << oWalk.GetDisassemblyInstructions().size() << " instructions" << std::endl;
+	std::cout << "Blocks        : " << aFunctions.size() << std::endl;
+	std::cout << "Output        : " << outputPath.string() << std::endl;
+	return 0;
+}
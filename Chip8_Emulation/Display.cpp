@@ -1,7 +1,7 @@
 #include "Display.h"
 #include "Chip8_Debugger.h"
 #include <iostream>
-#include "Chip8.h"
+#include "EmulationThread.h"
 #include <cstring>
 
 #include "TimeManager.h"
@@ -10,8 +10,6 @@
 const uint16_t WINDOW_WIDTH = 1920;
 const uint16_t WINDOW_HEIGHT = 1080;
 
-uint64_t Display::m_pPixels[ 2 ][ 64 ][ 2 ] = {0};
-
 bool Display::m_bDirtyFrame = false;
 Display* Display::m_pSingleton = nullptr;
 
@@ -20,13 +18,9 @@ unsigned int Display::m_iTexture = 0;
 
 uint8_t Display::m_iDisplayWidth = 0;
 uint8_t Display::m_iDisplayHeight = 0;
-uint8_t Display::m_iBitPlaneDrawIteration = 2;
 
 std::string Display::m_sGameTitle = "";
 
-#define WIDTH_DEFAULT_ON_ERROR 64
-#define HEIGHT_DEFAULT_ON_ERROR 32
-
 float vertices[] = {
 	// positions		//Texture coords
 	1.f, 1.0f, 0.0f,	0.0f, 0.0f,		// top right
@@ -46,8 +40,10 @@ Display::Display() :
 	m_iVBO( 0 ),
 	m_iEBO( 0 ),
 	m_iFBO( 0 ),
-	m_oResolutionMode( ResolutionMode::LORES ),
-	m_oCurrentBitMask( PlaneBitMask::PLANE1 )
+	m_oPresentMode( PresentMode::VSync ),
+	m_bAdaptiveSupported( false ),
+	m_iSwapInterval( -2 ),
+	m_iFrameVersion( 0 )
 {
 }
 
@@ -61,8 +57,9 @@ static void glfw_error_callback( int error,const char* description )
 	fprintf( stderr,"GLFW Error %d: %s\n",error,description );
 }
 
-int Display::Init( const KeyDisplayAccess& oKey,const Chip8* pCpu )
+int Display::Init( const KeyDisplayAccess& oKey,EmulationThread* pEmulation )
 {
+
 	glfwSetErrorCallback( glfw_error_callback );
 	if( !glfwInit() )
 		return -1;
@@ -75,23 +72,16 @@ int Display::Init( const KeyDisplayAccess& oKey,const Chip8* pCpu )
 		return -1;
 
 	_InitRenderer();
-	_InitPixelsData();
 	_InitFramebuffer();
+	m_bDirtyFrame = true;
 
 #ifdef DEBUG_INFO
-	Chip8_Debugger::GetInstance()->Init( m_pWindow,pCpu );
+	Chip8_Debugger::GetInstance()->Init( m_pWindow,pEmulation );
 #endif
 
 	return 0;
 }
 
-void Display::Reset( const KeyDisplayAccess& oKey )
-{
-	ClearScreen( oKey, true );
-	GetInstance()->m_oResolutionMode = ResolutionMode::LORES;
-	GetInstance()->m_oCurrentBitMask = PlaneBitMask::PLANE1;
-}
-
 int Display::_CreateWindowChip()
 {
 	// glfw window creation
@@ -116,6 +106,8 @@ int Display::_CreateWindowChip()
 		return -1;
 	}
 
+	m_bAdaptiveSupported = glfwExtensionSupported( "WGL_EXT_swap_control_tear" ) || glfwExtensionSupported( "GLX_EXT_swap_control_tear" );
+
 	return 0;
 }
 
@@ -194,13 +186,7 @@ void Display::_DestroyRenderer()
 	glDeleteFramebuffers( 1,&m_iFBO );
 }
 
-void Display::_InitPixelsData()
-{
-	memset( m_pPixels,0,sizeof( m_pPixels ) );
-	m_bDirtyFrame = true;
-}
-
-void Display::AssignDisplaySettings( bool bDefaultRes /*= false*/, const std::vector<std::string >& sColors /*= {}*/ )
+void Display::AssignDisplaySettings( const std::vector<std::string >& sColors /*= {}*/ )
 {
 	int iIndex = 0;
 
@@ -219,10 +205,6 @@ void Display::AssignDisplaySettings( bool bDefaultRes /*= false*/, const std::ve
 		};
 
 		glUniform4fv( iColorPaletteLocation,4,fDefaultPalette );
-
-		if( bDefaultRes )
-			SetResolution( WIDTH_DEFAULT_ON_ERROR, HEIGHT_DEFAULT_ON_ERROR );
-
 		return;
 	}
 
@@ -292,360 +274,22 @@ void Display::DestroyWindow( const KeyDisplayAccess& oKey )
 	delete m_pSingleton;
 }
 
-void Display::ClearScreen( const KeyDisplayAccess& oKey, const bool bReset /*= false*/ )
-{
-	PlaneBitMask oBitMask = GetInstance()->m_oCurrentBitMask;
-	if( oBitMask == PlaneBitMask::BOTH || bReset )
-		memset( m_pPixels,0,sizeof( m_pPixels ) );
-	else
-	{
-		int iMask = oBitMask - 1;
-		oBitMask = ( PlaneBitMask )iMask;
-		memset( m_pPixels[ iMask ],0,sizeof( m_pPixels[ iMask ] ) );
-	}
-	m_bDirtyFrame = true;
-}
-
-void Display::DrawPixelAtPos( const KeyDisplayAccess& oKey, const uint8_t xStartingPos, const uint8_t yStartingPos,uint8_t N,uint8_t& iVFFlag,bool bWrapping )
-{
-	uint8_t iBitMask = GetInstance()->m_oCurrentBitMask - 1;
-	if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH )
-	{
-		if( m_iBitPlaneDrawIteration == 2 )
-			m_iBitPlaneDrawIteration = 0;
-		
-		iBitMask = m_iBitPlaneDrawIteration;
-	}
-	else if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::NONE )
-		return;
-
-	Chip8* pInstance = Chip8::GetInstance();
-
-	uint8_t iCurrentX = xStartingPos & ( m_iDisplayWidth - 1 );
-	uint8_t iCurrentY = yStartingPos & ( m_iDisplayHeight - 1 );
-
-	int iSpriteSize = 8;
-	if( N == 0 )
-	{
-		uint8_t iIndex = m_iDisplayWidth == 64 ? 1 : 0;
-		uint8_t iIndex2 = iIndex == 0 ? 1 : 0;
-
-		iSpriteSize = 16;
-		for( uint8_t iYOffset = 0; iYOffset < 16; ++iYOffset,++iCurrentY )
-		{
-			if( !bWrapping )
-			{
-				if( iCurrentY >= m_iDisplayHeight )
-					return;
-			}
-			else if( bWrapping )
-				iCurrentY &= ( m_iDisplayHeight - 1 );
-
-			uint16_t iMemoryValue = *( pInstance->GetMemory()->begin() + pInstance->GetI() + ( iYOffset * 2 ) ) << 8 |
-									*( pInstance->GetMemory()->begin() + pInstance->GetI() + ( iYOffset * 2 ) + 1 );
-			if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH && iBitMask == 1 )
-			{
-				uint16_t iMemoryOffset = ( pInstance->GetI() + 32 ); //32 : 16 * 2
-				iMemoryValue = *( pInstance->GetMemory()->begin() + iMemoryOffset + ( iYOffset * 2 ) ) << 8 |
-							   *( pInstance->GetMemory()->begin() + iMemoryOffset + ( iYOffset * 2 ) + 1 );
-			}
-
-			uint64_t iLine = static_cast< uint64_t >( iMemoryValue ) << 48;
-
-			uint64_t iPreviousValue = m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ];
-			uint64_t iPreviousValue2 = m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ];
-
-			//Check in wich block we are, or if both
-			if( iCurrentX < 64 && iCurrentX + iSpriteSize >= 64 )
-			{
-				if( m_iDisplayWidth > 64 )
-				{
-					int xShift = iCurrentX + iSpriteSize;
-					int iAns = xShift - 64;
-
-					uint64_t iLine2 = iLine;
-					iLine <<= ( iSpriteSize - iAns );
-					iLine2 >>= iCurrentX;
-
-					iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] & iLine ) || ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] & iLine2 ) ? 1 : 0;
-
-					m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] ^= iLine;
-					m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] ^= iLine2;
-				}
-				else
-				{
-					if( bWrapping )
-						iLine = iLine >> iCurrentX | iLine << ( m_iDisplayWidth - iCurrentX );
-					else
-						iLine >>= iCurrentX;
-
-					m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] ^= iLine;
-				}
-
-				m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] ) || ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] );
-			}
-			else if( iCurrentX < 64 )
-			{
-				iLine >>= iCurrentX;
-
-				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] & iLine ) ? 1 : 0;
-				m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] ^= iLine;
-
-				m_bDirtyFrame |= ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] );
-			}
-			else if( iCurrentX >= 64 )
-			{
-				iLine >>= ( iCurrentX - 64 );
-
-				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] & iLine ) ? 1 : 0;
-				m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] ^= iLine;
-
-				if( bWrapping )
-				{
-					int xShift = iCurrentX + iSpriteSize;
-					if( xShift >= m_iDisplayWidth )
-					{
-						int iAns = xShift - 64;
-
-						uint64_t iLine2 = static_cast< uint64_t >( iMemoryValue ) << 48;
-						iLine2 <<= ( iSpriteSize - iAns );
-
-						iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] & iLine2 ) ? 1 : 0;
-						m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] ^= iLine2;
-					}
-				}
-
-				m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] ) || ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] );
-			}
-		}
-
-		if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH )
-		{
-			++m_iBitPlaneDrawIteration;
-			if( m_iBitPlaneDrawIteration != 2 )
-				DrawPixelAtPos( oKey,xStartingPos,yStartingPos,N,iVFFlag,bWrapping );
-		}
-		return;
-	}
-
-	for( uint8_t iYOffset = 0; iYOffset < N; ++iYOffset, ++iCurrentY )
-	{
-		if( !bWrapping )
-		{
-			if( iCurrentY >= m_iDisplayHeight )
-				return;
-		}
-		else if( bWrapping )
-			iCurrentY &= ( m_iDisplayHeight - 1 );
-
-		uint16_t iMemoryValue = 0;
-		uint64_t iLine = 0;
-
-		uint16_t iMemoryOffset = ( pInstance->GetI() + iYOffset );
-		if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH && iBitMask == 1 )
-			iMemoryOffset = ( pInstance->GetI() + N + iYOffset );
-
-#ifdef OVERFLOW_CONTROL
-		iMemoryOffset &= 0xFFF;
-#endif	
-		
-		if( GetResolutionMode() != ResolutionMode::HIRES )
-		{
-			uint64_t iPreviousValue = m_pPixels[ iBitMask ][ iCurrentY ][ 0 ];
-
-			iMemoryValue = ( uint8_t )*( pInstance->GetMemory()->begin() + iMemoryOffset );
-			iLine = static_cast<uint64_t>( iMemoryValue ) << 56; //Store as big endian in ram
-
-			if( iCurrentX != 0 )
-			{
-				if( bWrapping )
-					iLine = iLine >> iCurrentX | iLine << ( m_iDisplayWidth - iCurrentX );
-				else
-					iLine >>= iCurrentX;
-			}
-
-			iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] & iLine ) ? 1 : 0;
-			m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ^= iLine;
- 			m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] );
-		}
-		else
-		{
-			iMemoryValue = ( uint8_t )*( pInstance->GetMemory()->begin() + iMemoryOffset );
-
-			iLine = static_cast< uint64_t >( iMemoryValue ) << 56; //Store as big endian in ram
-
-			uint64_t iPreviousValue = m_pPixels[ iBitMask ][ iCurrentY ][ 0 ];
-			uint64_t iPreviousValue2 = m_pPixels[ iBitMask ][ iCurrentY ][ 1 ];
-
-			//Check in which block we are, or if both
-			if( iCurrentX < 64 && iCurrentX + iSpriteSize >= 64 )
-			{
-				int xShift = iCurrentX + iSpriteSize;
-				int iAns = xShift - 64;
-
-				uint64_t iLine2 = iLine;
-				iLine  <<= ( iSpriteSize - iAns );
-				iLine2 >>= iCurrentX;
-
-				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] & iLine ) || ( m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] & iLine2 ) ? 1 : 0;
-
-				m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ^= iLine;
-				m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] ^= iLine2;
-
-				m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ) || ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] );
-			}
-			else if( iCurrentX < 64 )
-			{
-				iLine >>= iCurrentX;
-
-				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] & iLine ) ? 1 : 0;
-				m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] ^= iLine;
-
-				m_bDirtyFrame |= iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ 1 ];
-			}
-			else if( iCurrentX >= 64 )
-			{
-				iLine >>= ( iCurrentX - 64 );
-
-				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] & iLine ) ? 1 : 0;
-				m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ^= iLine;
-
-				if( bWrapping )
-				{
-					int xShift = iCurrentX + iSpriteSize;
-					if( xShift >= m_iDisplayWidth )
-					{
-						int iAns = xShift - 64;
-						uint64_t iOverflow = static_cast< uint64_t >( iMemoryValue ) << 56;
-						iOverflow <<= ( iSpriteSize - iAns );
-						iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] & iOverflow ) ? 1 : 0;
-						m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] ^= iOverflow;
-					}
-				}
-
-				m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ) || ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] );
-			}
-		}
-	}
-
-	if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH )
-	{
-		++m_iBitPlaneDrawIteration;
-		if( m_iBitPlaneDrawIteration < 2 )
-			DrawPixelAtPos( oKey,xStartingPos, yStartingPos, N,iVFFlag, bWrapping );
-	}
-}
-
-void Display::ScrollVertical( const KeyDisplayAccess& oKey,uint8_t N, const bool bDown )
+void Display::Update( const MachineSnapshot& oSnapshot )
 {
-	uint8_t iBitMask = GetInstance()->m_oCurrentBitMask - 1;
-	if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH )
-	{
-		if( m_iBitPlaneDrawIteration == 2 )
-			m_iBitPlaneDrawIteration = 0;
-
-		iBitMask = m_iBitPlaneDrawIteration;
-	}
-	else if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::NONE )
-		return;
-
-	if( bDown )
-	{
-		N = Chip8::m_oCurrentQuirk.bLegacySrolling ? N / 2 : N;
-		for( int k = m_iDisplayHeight - 1; k >= 0; --k )
-		{
-			int iIndex = k - N;
-			if( iIndex < 0 )
-			{
-				m_pPixels[ iBitMask ][ k ][ 0 ] = 0; //Clip
-				if( GetResolutionMode() == ResolutionMode::HIRES )
-					m_pPixels[ iBitMask ][ k ][ 1 ] = 0;
-			}
-			else
-			{
-				m_pPixels[ iBitMask ][ k ][ 0 ] = m_pPixels[ iBitMask ][ iIndex ][ 0 ];
-				if( GetResolutionMode() == ResolutionMode::HIRES )
-					m_pPixels[ iBitMask ][ k ][ 1 ] = m_pPixels[ iBitMask ][ iIndex ][ 1 ];
-			}
-		}
-	}
-	else
-	{
-		for( int k = 0; k < m_iDisplayHeight; ++k )
-		{
-			int iIndex = k + N;
-			if( iIndex < m_iDisplayHeight )
-			{
-				m_pPixels[ iBitMask ][ k ][ 0 ] = m_pPixels[ iBitMask ][ iIndex ][ 0 ];
-				if( GetResolutionMode() == ResolutionMode::HIRES )
-					m_pPixels[ iBitMask ][ k ][ 1 ] = m_pPixels[ iBitMask ][ iIndex ][ 1 ];
-			}
-			else
-			{
-				m_pPixels[ iBitMask ][ k ][ 0 ] = 0; //Clip
-				if( GetResolutionMode() == ResolutionMode::HIRES )
-					m_pPixels[ iBitMask ][ k ][ 1 ] = 0;
-			}
-		}
-	}
+	const FrameBuffer& oFrameBuffer = oSnapshot.oFrameBuffer;
+	if( oFrameBuffer.GetWidth() != m_iDisplayWidth || oFrameBuffer.GetHeight() != m_iDisplayHeight )
+		_ApplyResolution( oFrameBuffer.GetWidth(),oFrameBuffer.GetHeight() );
 
-	if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH )
+	const int iSwapInterval = _GetSwapInterval();
+	if( iSwapInterval != m_iSwapInterval )
 	{
-		++m_iBitPlaneDrawIteration;
-		if( m_iBitPlaneDrawIteration < 2 )
-			ScrollVertical( oKey, N, bDown );
-	}
-}
-
-void Display::ScrollHorizontal( const KeyDisplayAccess& oKey, const bool bLeft )
-{
-	uint8_t iBitMask = GetInstance()->m_oCurrentBitMask - 1;
-	if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH )
-	{
-		if( m_iBitPlaneDrawIteration == 2 )
-			m_iBitPlaneDrawIteration = 0;
-
-		iBitMask = m_iBitPlaneDrawIteration;
-	}
-	else if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::NONE )
-		return;
-
-	uint8_t iScrollValue = Chip8::m_oCurrentQuirk.bLegacySrolling ? 2 : 4;
-	for( int k = 0; k < m_iDisplayHeight; ++k )
-	{
-		if( GetResolutionMode() == ResolutionMode::LORES )
-			bLeft ? m_pPixels[ iBitMask ][ k ][ 0 ] <<= iScrollValue : m_pPixels[ iBitMask ][ k ][ 0 ] >>= iScrollValue;
-		else
-		{
-			//Check if we push outside the block
-			if( bLeft )
-			{
-				uint8_t iBlockErase = ( m_pPixels[ iBitMask ][ k ][ 0 ] >> 60 ) & 0xF;
-
-				m_pPixels[ iBitMask ][ k ][ 0 ] <<= iScrollValue;
-				m_pPixels[ iBitMask ][ k ][ 1 ] = ( m_pPixels[ iBitMask ][ k ][ 1 ] << iScrollValue ) | iBlockErase;
-			}
-			else
-			{
-				uint64_t iBlockErase = m_pPixels[ iBitMask ][ k ][ 1 ] & 0xF;
-
-				m_pPixels[ iBitMask ][ k ][ 1 ] >>= iScrollValue;
-				m_pPixels[ iBitMask ][ k ][ 0 ] = ( m_pPixels[ iBitMask ][ k ][ 0 ] >> iScrollValue ) | ( iBlockErase << 60 );
-			}
-		}
+		glfwSwapInterval( iSwapInterval );
+		m_iSwapInterval = iSwapInterval;
 	}
+	if( TimeManager::GetPacingMode() == PacingMode::VSync ) //Needs a swap every loop to block on
+		m_bDirtyFrame = true;
 
-	if( GetInstance()->m_oCurrentBitMask == PlaneBitMask::BOTH )
-	{
-		++m_iBitPlaneDrawIteration;
-		if( m_iBitPlaneDrawIteration < 2 )
-			ScrollHorizontal( oKey, bLeft );
-	}
-}
-
-void Display::Update( const bool cpuPaused )
-{
-	if( m_bDirtyFrame )
+	if( m_bDirtyFrame || oSnapshot.iFrameVersion != m_iFrameVersion )
 	{
 			glClearColor( 0.f,0.f,0.f,1.f );
 			glClear( GL_COLOR_BUFFER_BIT );
@@ -653,7 +297,7 @@ void Display::Update( const bool cpuPaused )
 #ifdef DEBUG_INFO
 			glBindFramebuffer( GL_FRAMEBUFFER,m_iFBO );
 #endif
-			glTexSubImage3D( GL_TEXTURE_2D_ARRAY,0,0,0,0,4,Display::GetHeight(),2,GL_RED_INTEGER,GL_UNSIGNED_INT,m_pPixels );
+			glTexSubImage3D( GL_TEXTURE_2D_ARRAY,0,0,0,0,4,Display::GetHeight(),2,GL_RED_INTEGER,GL_UNSIGNED_INT,oFrameBuffer.GetPixels() );
 
 			m_sShaderProgram.Use();
 
@@ -665,23 +309,42 @@ void Display::Update( const bool cpuPaused )
 			glfwSwapBuffers( m_pWindow );
 #endif
 			m_bDirtyFrame = false;
+			m_iFrameVersion = oSnapshot.iFrameVersion;
 	}
 
 #ifdef DEBUG_INFO
-	Chip8_Debugger::GetInstance()->Update( TimeManager::GetTimeLastFrame() );
+	Chip8_Debugger::GetInstance()->Update( TimeManager::GetTimeLastFrame(),oSnapshot );
 	Chip8_Debugger::GetInstance()->Render();
 	glfwSwapBuffers( m_pWindow );
 #endif
 
 	std::string sPerfDebug = std::format( "{} : {} ms",m_sGameTitle,*TimeManager::GetTimeLastFrame() );
+	if( TimeManager::IsTurbo() )
+		sPerfDebug += std::format( " : turbo x{:.1f}",TimeManager::GetSpeedMultiple() );
 	glfwSetWindowTitle( m_pWindow,sPerfDebug.c_str() );
 }
 
-void Display::SetResolution( const int iWidth,const int iHeight )
+int Display::_GetSwapInterval() const
 {
-	if( m_iDisplayWidth == iWidth && m_iDisplayHeight == iHeight )
-		return;
+	if( TimeManager::IsTurbo() ) //Never waits on the screen
+		return 0;
+
+	PresentMode oMode = m_oPresentMode;
+	if( oMode == PresentMode::Immediate && TimeManager::GetPacingMode() == PacingMode::VSync ) //The swap is the pacing, it has to block
+		oMode = PresentMode::VSync;
+	if( oMode == PresentMode::Adaptive && !m_bAdaptiveSupported )
+		oMode = PresentMode::VSync;
+
+	switch( oMode )
+	{
+		case PresentMode::VSync:	return 1;
+		case PresentMode::Adaptive:	return -1;
+		default:					return 0;
+	}
+}
 
+void Display::_ApplyResolution( const int iWidth,const int iHeight )
+{
 	m_iDisplayWidth = iWidth;
 	m_iDisplayHeight = iHeight;
 	int iWithLocation = glGetUniformLocation( m_sShaderProgram.ID,"Width" );
@@ -691,35 +354,10 @@ void Display::SetResolution( const int iWidth,const int iHeight )
 
 	glUniform1i( iWithLocation,m_iDisplayWidth );
 	glUniform1i( iHeightLocation,m_iDisplayHeight );
-	glUniform1i( iHeightLocation,m_iDisplayHeight );
 
 	//Update texture with new res
 	glBindTexture( GL_TEXTURE_2D_ARRAY,m_iTexture );
 	glTexImage3D( GL_TEXTURE_2D_ARRAY,0,GL_R32UI,4,iHeight,2,0,GL_RED_INTEGER,GL_UNSIGNED_INT,NULL );//Beware to Display::Update glTexSubImage2D call
 
 	m_bDirtyFrame = true;
-
-#ifdef DEBUG_INFO
-	std::cout << std::format( "DISPLAY::CHANGE_CURRENT_RESOLUTION_{}x{}",m_iDisplayWidth,m_iDisplayHeight ) << std::endl;
-#endif
-}
-
-void Display::SetResolutionMode( const ResolutionMode oResolutionMode )
-{
-	//Keep res as power of two or instruction in draw opcode might give you exotic result
-	if( m_oResolutionMode != oResolutionMode )
-		m_oResolutionMode = oResolutionMode;
-
-	switch( m_oResolutionMode )
-	{
-	case ResolutionMode::HIRES:
-		SetResolution( 128,64 );
-		break;
-	case ResolutionMode::LORES:
-		SetResolution( 64,32 );
-		break;
-	default:
-		std::cerr << "Should not pass here with that value" << std::endl;
-		break;
-	}
 }
\ No newline at end of file
@@ -3,24 +3,22 @@
 #include <GLFW/glfw3.h>
 #include "Shader.h"
 #include <chrono>
+#include <string>
+#include <vector>
 
-#define DEBUG_INFO
-
-enum ResolutionMode
-{
-	LORES,
-	HIRES
-};
+class Chip8;
+class EmulationThread;
+struct MachineSnapshot;
 
-enum PlaneBitMask
+//What the buffer swap waits for, set explicitly instead of left to the driver
+enum class PresentMode
 {
-	NONE, //Can happen on xochip, we don't draw anything in this case
-	PLANE1, //By default for CHIP 8 / Superchip
-	PLANE2,
-	BOTH
+	VSync,		//Swap interval 1, no tearing, up to a refresh of latency. The default
+	Adaptive,	//Swap interval -1, waits on vblank unless the frame is late, VSync without the tear control extension
+	Immediate,	//Swap interval 0, never waits : the pacing is the only wait
+	Count,
 };
 
-class Chip8;
 class alignas( 16 ) Display
 {
 
@@ -28,32 +26,30 @@ public:
 	class KeyDisplayAccess
 	{
 		friend int main( int argc,char** argv );
-		friend int Quit();
+		friend int Quit( Chip8* pCpu );
 		friend class Chip8;
 		friend class Chip8_Debugger;
 		KeyDisplayAccess() {}
 	};
 
-	int Init( const KeyDisplayAccess& oKey,const Chip8* pCpu );
-	static void Reset( const KeyDisplayAccess& oKey );
-	static void ClearScreen( const KeyDisplayAccess& oKey, const bool bReset = false );
-	static void DrawPixelAtPos( const KeyDisplayAccess& oKey, const uint8_t xStartingPos,const uint8_t yStartingPos,const uint8_t N,uint8_t& iVFFlag,bool bWrapping );
-	static void ScrollVertical( const KeyDisplayAccess& oKey, uint8_t N,const bool bDown );
-	static void ScrollHorizontal( const KeyDisplayAccess& oKey, const bool bLeft );
+	int Init( const KeyDisplayAccess& oKey,EmulationThread* pEmulation );
 	void DestroyWindow( const KeyDisplayAccess& oKey );
 
-	void Update( const bool cpuPaused );
+	void Update( const MachineSnapshot& oSnapshot );
 
 	const unsigned int& GetFBOTexture() const { return m_iFBOTexture; }
 	GLFWwindow* GetWindow() const { return m_pWindow; }
-
-	void SetResolution( const int iWidth, const int iHeight );
+	bool IsIconified() const { return glfwGetWindowAttrib( m_pWindow,GLFW_ICONIFIED ) != 0; }
+	bool IsInBackground() const { return IsIconified() || glfwGetWindowAttrib( m_pWindow,GLFW_FOCUSED ) == 0; }
 
 	static const uint8_t GetWidth() { return m_iDisplayWidth; }
 	static const uint8_t GetHeight() { return m_iDisplayHeight; }
 
 	static void SetGameTitle( const std::string& sTitle ){ m_sGameTitle = sTitle; }
-	void AssignDisplaySettings( bool bDefaultRes = false, const std::vector<std::string >& sColors = {} );
+	void SetPresentMode( const PresentMode oMode ) { m_oPresentMode = oMode; }
+	PresentMode GetPresentMode() const { return m_oPresentMode; }
+	bool IsAdaptiveSupported() const { return m_bAdaptiveSupported; }
+	void AssignDisplaySettings( const std::vector<std::string >& sColors = {} );
 
 	static Display* GetInstance()
 	{
@@ -62,20 +58,17 @@ public:
 		return m_pSingleton;
 	}
 
-	void SetResolutionMode( const ResolutionMode oResolutionMode );
-	void SetPlaneBitmask( const uint8_t oPlaneBitMask ){ m_oCurrentBitMask = ( PlaneBitMask )oPlaneBitMask; }
-	static ResolutionMode GetResolutionMode() { return GetInstance()->m_oResolutionMode;}
-
 protected:
 	Display();
 	~Display();
 
 	int _CreateWindowChip();
+	int _GetSwapInterval() const;
 	void _InitTexture();
 	void _InitFramebuffer();
 	void _InitRenderer();
 	void _DestroyRenderer();
-	static void _InitPixelsData();
+	void _ApplyResolution( const int iWidth,const int iHeight );
 
 	static void framebuffer_size_callback( GLFWwindow* m_pWindow,int width,int height );
 
@@ -91,16 +84,13 @@ protected:
 	unsigned int 						m_iEBO;
 	unsigned int						m_iFBO;
 
-	static uint64_t						m_pPixels[ 2 ][ 64 ][ 2 ]; //bitmask || Width || 32Bit block
-
-	static bool							m_bDirtyFrame;
+	static bool							m_bDirtyFrame; //Host side redraw request ( resize ), guest side is tracked by the FrameBuffer
+	PresentMode							m_oPresentMode;
+	bool								m_bAdaptiveSupported;
+	int									m_iSwapInterval;
+	uint32_t							m_iFrameVersion; //Of the guest frame on screen
 	static uint8_t						m_iDisplayWidth;
 	static uint8_t						m_iDisplayHeight;
 
 	static std::string					m_sGameTitle;
-
-	
-	ResolutionMode						m_oResolutionMode;
-	PlaneBitMask						m_oCurrentBitMask;
-	static uint8_t						m_iBitPlaneDrawIteration;
 };
@@ -0,0 +1,317 @@
+#include "EmulationThread.h"
+#include "TimeManager.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#define MAX_LATE_GUEST_FRAMES 4 //Past that the host can't keep up, the late frames are dropped
+
+EmulationThread::EmulationThread( Chip8* pCpu ) :
+	m_pCpu( pCpu ),
+	m_bQuit( false ),
+	m_bSuspended( false ),
+	m_iSignal( 0 ),
+	m_pSnapshots( std::make_unique< TripleBuffer< MachineSnapshot > >() ),
+	m_iSequence( 0 ),
+	m_bPublishWaiter( false ),
+	m_iLastKeys( 0 ),
+	m_iGuestFrames( 0 ),
+	m_iFrameVersion( 0 ),
+	m_iPatternVersion( 0 ),
+	m_iPitchVersion( 0 ),
+	m_iLoadCount( 0 )
+{}
+
+EmulationThread::~EmulationThread()
+{
+	Stop();
+}
+
+void EmulationThread::Start()
+{
+	if( IsThreaded() )
+		return;
+
+	Publish(); //The UI has a snapshot before the first frame
+	m_bQuit = false;
+	m_oThread = std::thread( &EmulationThread::_Run,this );
+}
+
+void EmulationThread::Stop()
+{
+	if( !IsThreaded() )
+		return;
+
+	m_bQuit = true;
+	_Signal();
+	m_oThread.join();
+}
+
+void EmulationThread::Push( const MachineCommand& oCommand )
+{
+	if( !m_oCommands.Push( oCommand ) )
+		std::cerr << "ERROR::EMULATION::COMMAND_QUEUE_FULL" << std::endl;
+	_Signal();
+}
+
+void EmulationThread::Push( const MachineCommandType oType,const int iValue )
+{
+	MachineCommand oCommand;
+	oCommand.oType = oType;
+	oCommand.iValue = iValue;
+	Push( oCommand );
+}
+
+void EmulationThread::PushLoadRom( const std::string& sPath )
+{
+	MachineCommand oCommand;
+	oCommand.oType = MachineCommandType::LoadRom;
+	if( sPath.size() >= sizeof( oCommand.sPath ) )
+	{
+		std::cerr << "ERROR::EMULATION::ROM_PATH_TOO_LONG " << sPath << std::endl;
+		return;
+	}
+	memcpy( oCommand.sPath,sPath.c_str(),sPath.size() + 1 );
+	Push( oCommand );
+}
+
+void EmulationThread::SetKeys( const uint16_t iKeys )
+{
+	if( iKeys == m_iLastKeys )
+		return;
+	m_iLastKeys = iKeys;
+	Push( MachineCommandType::SetKeys,iKeys );
+}
+
+void EmulationThread::SetSuspended( const bool bSuspended )
+{
+	if( m_bSuspended.exchange( bSuspended ) != bSuspended )
+		_Signal();
+}
+
+const MachineSnapshot& EmulationThread::Acquire()
+{
+	m_pSnapshots->Acquire();
+	return m_pSnapshots->GetReadBuffer();
+}
+
+bool EmulationThread::WaitForPublish( const uint64_t iSeen,const std::chrono::nanoseconds iTimeout )
+{
+	std::unique_lock< std::mutex > oLock( m_oPublishMutex );
+	//Raised before the sequence is read : a publish after the read sees it and notifies
+	m_bPublishWaiter = true;
+	const bool bPublished = m_oPublishCondition.wait_for( oLock,iTimeout,[ & ]{ return m_iSequence.load() > iSeen; } );
+	m_bPublishWaiter = false;
+	return bPublished;
+}
+
+void EmulationThread::ApplyCommands( const Chip8::KeyAccess& oKey )
+{
+	MachineCommand oCommand;
+	while( m_oCommands.Pop( oCommand ) )
+	{
+		switch( oCommand.oType )
+		{
+			case MachineCommandType::SetState:
+				m_pCpu->AskForState( oKey,static_cast< RunningState >( oCommand.iValue ) );
+				break;
+			case MachineCommandType::LoadRom:
+				m_pCpu->SetROMPathFileToLoad( oKey,oCommand.sPath );
+				m_pCpu->AskForState( oKey,RunningState::LoadNewRom );
+				break;
+			case MachineCommandType::SetKeys:
+				for( uint8_t i = 0; i < 0x10; ++i )
+					m_pCpu->SetKeyState( i,( oCommand.iValue >> i ) & 1 );
+				break;
+			case MachineCommandType::SetInstructionsPerFrame:
+				m_pCpu->SetInstructionPerFrame( oCommand.iValue );
+				break;
+			case MachineCommandType::SetIpfGovernor:
+				m_pCpu->SetIpfGovernor( oCommand.iValue != 0 );
+				break;
+			case MachineCommandType::SetEngine:
+				m_pCpu->SetExecutionEngine( static_cast< ExecutionEngine >( oCommand.iValue ) );
+				break;
+			case MachineCommandType::SetDispatch:
+				m_pCpu->SetInterpreterDispatch( static_cast< InterpreterDispatch >( oCommand.iValue ) );
+				break;
+#ifdef DEBUG_INFO
+			case MachineCommandType::AttachDebugger:
+				if( oCommand.iValue != 0 )
+					m_pCpu->AttachDebugger( oKey );
+				else
+					m_pCpu->DetachDebugger( oKey );
+				break;
+			case MachineCommandType::SetBreakpoint:
+				m_pCpu->SetBreakpoint( static_cast< uint16_t >( oCommand.iValue ) );
+				break;
+#endif
+			case MachineCommandType::Quit:
+				m_bQuit = true;
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+bool EmulationThread::RunFrame( const Chip8::KeyAccess& oKey )
+{
+	const bool bRunning = m_pCpu->IsRunning();
+	m_pCpu->EmulateCycle( oKey );
+	if( bRunning )
+		++m_iGuestFrames;
+	return m_pCpu->IsRunning();
+}
+
+void EmulationThread::Publish()
+{
+	MachineSnapshot& oSnapshot = m_pSnapshots->GetWriteBuffer();
+
+	//Dirty flags are consumed here, the reader may never see the snapshot that had them
+	FrameBuffer& oFrameBuffer = m_pCpu->GetFrameBuffer();
+	if( oFrameBuffer.IsDirty() )
+	{
+		++m_iFrameVersion;
+		oFrameBuffer.SetDirty( false );
+	}
+	oSnapshot.oFrameBuffer = oFrameBuffer;
+	oSnapshot.iFrameVersion = m_iFrameVersion;
+
+	AudioRegisters& oAudio = m_pCpu->GetAudioRegisters();
+	if( oAudio.bNewPattern )
+		++m_iPatternVersion;
+	if( oAudio.bNewPitch )
+		++m_iPitchVersion;
+	oAudio.bNewPattern = oAudio.bNewPitch = false;
+	oSnapshot.oAudio = oAudio;
+	oSnapshot.iPatternVersion = m_iPatternVersion;
+	oSnapshot.iPitchVersion = m_iPitchVersion;
+
+	for( uint8_t i = 0; i < 0x10; ++i )
+	{
+		oSnapshot.aRegisters[ i ] = m_pCpu->GetRegisters()[ i ];
+		oSnapshot.aStack[ i ] = m_pCpu->GetStack()[ i ];
+	}
+	oSnapshot.iI = m_pCpu->GetI();
+	oSnapshot.iPC = m_pCpu->GetPC();
+	oSnapshot.iSP = m_pCpu->GetSP();
+	oSnapshot.iDelayTimer = m_pCpu->GetDelayTimer();
+	oSnapshot.iSoundTimer = m_pCpu->GetSoundTimer();
+
+	//Only the attached debugger reads the memory, the frontend itself needs the screen and the audio registers
+	uint32_t iMemorySize = 0;
+#ifdef DEBUG_INFO
+	if( m_pCpu->IsDebuggerAttached() )
+	{
+		iMemorySize = m_pCpu->GetMemorySize();
+		m_pCpu->CopyMemory( oSnapshot.aMemory.data() );
+	}
+#endif
+	if( oSnapshot.iMemorySize > iMemorySize ) //Only a smaller address space or a detach leaves bytes of a previous copy
+		std::fill( oSnapshot.aMemory.begin() + iMemorySize,oSnapshot.aMemory.begin() + oSnapshot.iMemorySize,0 );
+	oSnapshot.iMemorySize = iMemorySize;
+
+	oSnapshot.iCycle = m_pCpu->GetCycleId();
+	oSnapshot.iGuestFrames = m_iGuestFrames;
+	oSnapshot.oState = m_pCpu->GetState();
+	oSnapshot.oHalt = m_pCpu->GetHaltState();
+
+	oSnapshot.iInstructionsPerFrame = m_pCpu->GetInstructPerFrame();
+	oSnapshot.iMaxInstructionsPerFrame = m_pCpu->GetMaxInstructPerFrame();
+	oSnapshot.bIpfGovernor = m_pCpu->IsIpfGovernorEnabled();
+	oSnapshot.oEngine = m_pCpu->GetExecutionEngine();
+	oSnapshot.oDispatch = m_pCpu->GetInterpreterDispatch();
+	oSnapshot.bAotModule = m_pCpu->HasAotModule();
+#ifdef DEBUG_INFO
+	oSnapshot.bDebuggerAttached = m_pCpu->IsDebuggerAttached();
+	oSnapshot.iBreakpoint = m_pCpu->GetBreakpointAdress();
+#endif
+	oSnapshot.oQuirk = m_pCpu->m_oCurrentQuirk;
+	oSnapshot.oDecodeCacheStats = m_pCpu->GetDecodeCacheStats();
+	oSnapshot.oBlockCacheStats = m_pCpu->GetBlockCacheStats();
+	oSnapshot.oIdleLoopStats = m_pCpu->GetIdleLoopStats();
+
+	//Settings and disassembly only change with a load, copied once and shared by the snapshots after it
+	if( m_pRom == nullptr || m_iLoadCount != m_pCpu->GetLoadCount() )
+	{
+		std::shared_ptr< LoadedRom > pRom = std::make_shared< LoadedRom >();
+		if( m_pCpu->GetCurrentRomLoaded() != nullptr )
+			pRom->sPath = m_pCpu->GetCurrentRomLoaded();
+		pRom->oSettings = m_pCpu->GetRomSettings();
+#ifdef DEBUG_INFO
+		pRom->oDisassembler = m_pCpu->GetDisassembler();
+#endif
+		m_pRom = std::move( pRom );
+		m_iLoadCount = m_pCpu->GetLoadCount();
+	}
+	oSnapshot.iLoadCount = m_iLoadCount;
+	oSnapshot.pRom = m_pRom;
+	oSnapshot.iSequence = m_iSequence.load( std::memory_order_relaxed ) + 1;
+
+	m_pSnapshots->Publish();
+	m_iSequence.store( oSnapshot.iSequence );
+	if( m_bPublishWaiter )
+	{
+		std::lock_guard< std::mutex > oLock( m_oPublishMutex );
+		m_oPublishCondition.notify_one();
+	}
+}
+
+void EmulationThread::_Run()
+{
+	Chip8::KeyAccess oKey;
+	steady_clock_point iNextFrame = std::chrono::steady_clock::now();
+	uint32_t iSkippedFrames = 0; //Turbo frames run since the last publish
+	while( !m_bQuit )
+	{
+		//Read before the commands are applied : one pushed after it wakes the wait below
+		const uint32_t iSignal = m_iSignal.load( std::memory_order_acquire );
+		ApplyCommands( oKey );
+		if( m_bQuit )
+			break;
+
+		if( _IsIdle() )
+		{
+			Publish(); //The UI sees the pause, the stop or the last commands
+			m_iSignal.wait( iSignal,std::memory_order_acquire );
+			iNextFrame = std::chrono::steady_clock::now();
+			iSkippedFrames = 0;
+			continue;
+		}
+
+		//The guest keeps its 60 Hz on its own clock, turbo runs the frames back to back
+		const steady_clock_point iNow = std::chrono::steady_clock::now();
+		const bool bTurbo = TimeManager::IsTurbo();
+		if( bTurbo )
+			iNextFrame = iNow;
+		else
+		{
+			if( iNextFrame > iNow )
+				std::this_thread::sleep_until( iNextFrame );
+			iNextFrame = std::max( iNextFrame + TimeManager::s_iGuestFrame,iNow - TimeManager::s_iGuestFrame * MAX_LATE_GUEST_FRAMES );
+		}
+
+		//A guest that settles into its timer wait ends the frame there, the rest of its cycles are skipped :
+		//the publish right after is as soon as the frame is drawn, what present early waits on
+		//In turbo with a frame skip only every Nth frame is published, the UI never sees the ones in between
+		const bool bRunning = RunFrame( oKey );
+		const uint32_t iFrameSkip = bTurbo ? TimeManager::GetTurboFrameSkip() : 0;
+		if( iFrameSkip != 0 && ++iSkippedFrames < iFrameSkip && bRunning )
+			continue;
+		iSkippedFrames = 0;
+		Publish();
+	}
+	Publish();
+}
+
+bool EmulationThread::_IsIdle() const
+{
+	return m_bSuspended || m_pCpu->IsPause() || m_pCpu->IsStop();
+}
+
+void EmulationThread::_Signal()
+{
+	m_iSignal.fetch_add( 1,std::memory_order_release );
+	m_iSignal.notify_one();
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+#include "Chip8.h"
+#include "LockFree.h"
+
+#define COMMAND_QUEUE_SIZE 64
+
+//Changed on load only, every snapshot of the same ROM points to the same one
+struct LoadedRom
+{
+	std::string							sPath; //Empty when nothing is loaded
+	RomSettings							oSettings;
+	Disassembler						oDisassembler;
+};
+
+//The machine as it was at the end of a guest frame, all the frontend and the debugger read
+struct MachineSnapshot
+{
+	FrameBuffer							oFrameBuffer;
+	uint32_t							iFrameVersion = 0; //Bumped on each frame the guest drew in
+
+	std::array< Data< uint8_t >,0x10 >	aRegisters;
+	std::array< Data< uint16_t >,0x10 >	aStack;
+	Data< uint16_t >					iI;
+	Data< uint16_t >					iPC;
+	Data< uint8_t >						iSP;
+	Data< uint8_t >						iDelayTimer;
+	Data< uint8_t >						iSoundTimer;
+	std::array< uint8_t,MemoryMap::XOCHIP_MEMORY_SIZE > aMemory; //Bytes past iMemorySize stay at 0
+	uint32_t							iMemorySize = 0; //0 while the debugger is detached, the memory is not copied
+	long long unsigned					iCycle = 0;
+	uint64_t							iGuestFrames = 0; //Emulated since the thread started, for the speed multiple
+	uint64_t							iSequence = 0; //Bumped by every publish, for WaitForPublish
+
+	RunningState						oState = RunningState::Pause;
+	HaltState							oHalt = HaltState::None;
+
+	//The flags of AudioRegisters are consumed by the thread, a version changes instead
+	AudioRegisters						oAudio;
+	uint32_t							iPatternVersion = 0;
+	uint32_t							iPitchVersion = 0;
+
+	int									iInstructionsPerFrame = 0;
+	int									iMaxInstructionsPerFrame = 0;
+	bool								bIpfGovernor = false;
+	ExecutionEngine						oEngine = ExecutionEngine::Interpreter;
+	InterpreterDispatch					oDispatch = InterpreterDispatch::Switch;
+	bool								bAotModule = false;
+	bool								bDebuggerAttached = false;
+	uint16_t							iBreakpoint = 0;
+	Quirk								oQuirk;
+	DecodeCacheStats					oDecodeCacheStats;
+	BlockCacheStats						oBlockCacheStats;
+	IdleLoopStats						oIdleLoopStats;
+
+	uint32_t							iLoadCount = 0;
+	std::shared_ptr< const LoadedRom >	pRom;
+
+	bool IsPause() const { return oState == RunningState::Pause; }
+	bool IsStop() const { return oState == RunningState::Stop; }
+	bool IsRunning() const { return oState == RunningState::Running; }
+	const char* GetCurrentRomLoaded() const { return pRom == nullptr || pRom->sPath.empty() ? nullptr : pRom->sPath.c_str(); }
+};
+
+enum class MachineCommandType : uint8_t
+{
+	SetState,
+	LoadRom,
+	SetKeys,
+	SetInstructionsPerFrame,
+	SetIpfGovernor,
+	SetEngine,
+	SetDispatch,
+	AttachDebugger,
+	SetBreakpoint,
+	Quit,
+};
+
+//What the frontend asks the machine, applied by the thread that owns it between two guest frames
+struct MachineCommand
+{
+	MachineCommandType					oType = MachineCommandType::Quit;
+	int									iValue = 0;
+	char								sPath[ 260 ] = {}; //LoadRom only
+};
+
+//Owns the machine : runs it on its own thread, or inline from main when there is none
+//Only the snapshots go out and only the commands come in, the frontend never touches the Chip8
+class EmulationThread
+{
+public:
+	EmulationThread( Chip8* pCpu );
+	~EmulationThread();
+
+	void								Start();
+	void								Stop();
+	bool								IsThreaded() const { return m_oThread.joinable(); }
+
+	//UI side, any number of calls per frame
+	void								Push( const MachineCommand& oCommand );
+	void								Push( const MachineCommandType oType,const int iValue = 0 );
+	void								PushLoadRom( const std::string& sPath );
+	void								SetKeys( const uint16_t iKeys );
+	//The guest stays where it is, no frame is run until resumed
+	void								SetSuspended( const bool bSuspended );
+
+	//Latest snapshot published, the same one until the next call that finds a newer one
+	const MachineSnapshot&				Acquire();
+	//Blocks until a snapshot newer than iSeen is published, false on timeout
+	bool								WaitForPublish( const uint64_t iSeen,const std::chrono::nanoseconds iTimeout );
+
+	//Without a thread main drives the machine itself through these
+	void								ApplyCommands( const Chip8::KeyAccess& oKey );
+	bool								RunFrame( const Chip8::KeyAccess& oKey ); //False once the machine no longer runs
+	void								Publish();
+
+private:
+	void								_Run();
+	bool								_IsIdle() const;
+	void								_Signal();
+
+	Chip8*								m_pCpu;
+	std::thread							m_oThread;
+	std::atomic< bool >					m_bQuit;
+	std::atomic< bool >					m_bSuspended;
+	std::atomic< uint32_t >				m_iSignal; //Bumped by every command and suspend change, the idle thread waits on it
+
+	SpscQueue< MachineCommand,COMMAND_QUEUE_SIZE > m_oCommands;
+	std::unique_ptr< TripleBuffer< MachineSnapshot > > m_pSnapshots;
+	std::atomic< uint64_t >				m_iSequence;
+
+	//Only taken when the UI waits on a frame, the publish stays lock free otherwise
+	std::mutex							m_oPublishMutex;
+	std::condition_variable				m_oPublishCondition;
+	std::atomic< bool >					m_bPublishWaiter;
+
+	uint16_t							m_iLastKeys; //UI side, keys are only sent when they change
+	uint64_t							m_iGuestFrames;
+	uint32_t							m_iFrameVersion;
+	uint32_t							m_iPatternVersion;
+	uint32_t							m_iPitchVersion;
+	uint32_t							m_iLoadCount;
+	std::shared_ptr< const LoadedRom >	m_pRom;
+};
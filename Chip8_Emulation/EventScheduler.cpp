@@ -0,0 +1,49 @@
+#include "EventScheduler.h"
+#include <algorithm>
+
+//Events per second of guest time, a period is iCyclesPerFrame * 60 / rate cycles
+static constexpr uint16_t s_aEventRates[] = { 60,60,60,60 };
+static_assert( sizeof( s_aEventRates ) / sizeof( s_aEventRates[ 0 ] ) == static_cast< size_t >( GuestEvent::Count ),"One rate per event" );
+
+static uint64_t GetPeriod( const GuestEvent oEvent,const uint32_t iCyclesPerFrame )
+{
+	return std::max< uint64_t >( 1,static_cast< uint64_t >( iCyclesPerFrame ) * 60 / s_aEventRates[ static_cast< size_t >( oEvent ) ] );
+}
+
+EventScheduler::EventScheduler() :
+	m_iNextCycle( 0 )
+{
+	m_aDueCycles.fill( 0 );
+}
+
+void EventScheduler::Reset( const uint64_t iNow,const uint32_t iCyclesPerFrame )
+{
+	for( size_t i = 0; i < m_aDueCycles.size(); ++i )
+		m_aDueCycles[ i ] = iNow + GetPeriod( static_cast< GuestEvent >( i ),iCyclesPerFrame );
+	m_aDueCycles[ static_cast< size_t >( GuestEvent::InputSample ) ] = iNow;
+	_UpdateNextCycle();
+}
+
+GuestEvent EventScheduler::PopDue( const uint64_t iNow,const uint32_t iCyclesPerFrame )
+{
+	if( m_iNextCycle > iNow )
+		return GuestEvent::None;
+
+	//Lowest cycle first, lowest id first on a tie
+	size_t iEvent = 0;
+	for( size_t i = 1; i < m_aDueCycles.size(); ++i )
+	{
+		if( m_aDueCycles[ i ] < m_aDueCycles[ iEvent ] )
+			iEvent = i;
+	}
+
+	const GuestEvent oEvent = static_cast< GuestEvent >( iEvent );
+	m_aDueCycles[ iEvent ] += GetPeriod( oEvent,iCyclesPerFrame );
+	_UpdateNextCycle();
+	return oEvent;
+}
+
+void EventScheduler::_UpdateNextCycle()
+{
+	m_iNextCycle = *std::min_element( m_aDueCycles.begin(),m_aDueCycles.end() );
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//Things that happen on the guest clock, fired in this order when they fall on the same cycle
+enum class GuestEvent : uint8_t
+{
+	TimerTick,		//Delay and sound timers count down, 60 Hz
+	AudioUpdate,	//Buzzer state published to the frontend, 60 Hz
+	VBlank,			//End of a guest frame, the screen can be shown
+	InputSample,	//Keys given by the host become visible to the guest, at the start of each frame
+	Count,
+	None = Count
+};
+
+//Emulated clock counted in cycles ( one per instruction, iCyclesPerFrame of them in 1/60 s )
+//Nothing here looks at the host clock : an uncapped or fast-forwarded run keeps the guest timings
+class EventScheduler
+{
+public:
+	EventScheduler();
+
+	//Every event armed again from iNow, the first input sample right away
+	void							Reset( const uint64_t iNow,const uint32_t iCyclesPerFrame );
+	uint64_t						GetNextCycle() const { return m_iNextCycle; }
+	uint64_t						GetEventCycle( const GuestEvent oEvent ) const { return m_aDueCycles[ static_cast< size_t >( oEvent ) ]; }
+
+	//Earliest event due at iNow, re-armed one period later at the current rate. None when nothing is due
+	GuestEvent						PopDue( const uint64_t iNow,const uint32_t iCyclesPerFrame );
+
+private:
+	void							_UpdateNextCycle();
+
+	std::array< uint64_t,static_cast< size_t >( GuestEvent::Count ) > m_aDueCycles;
+	uint64_t						m_iNextCycle; //Smallest of m_aDueCycles
+};
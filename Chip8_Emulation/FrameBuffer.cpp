@@ -0,0 +1,410 @@
+#include "FrameBuffer.h"
+#include "Chip8.h"
+#include <cstring>
+#include <iostream>
+#include <format>
+
+FrameBuffer::FrameBuffer() :
+	m_pPixels{ 0 },
+	m_bDirtyFrame( true ),
+	m_iDisplayWidth( 64 ),
+	m_iDisplayHeight( 32 ),
+	m_iBitPlaneDrawIteration( 2 ),
+	m_oResolutionMode( ResolutionMode::LORES ),
+	m_oCurrentBitMask( PlaneBitMask::PLANE1 )
+{
+}
+
+void FrameBuffer::Reset()
+{
+	ClearScreen( true );
+	m_oResolutionMode = ResolutionMode::LORES;
+	m_oCurrentBitMask = PlaneBitMask::PLANE1;
+}
+
+void FrameBuffer::ClearScreen( const bool bReset /*= false*/ )
+{
+	PlaneBitMask oBitMask = m_oCurrentBitMask;
+	if( oBitMask == PlaneBitMask::BOTH || bReset )
+		memset( m_pPixels,0,sizeof( m_pPixels ) );
+	else
+	{
+		int iMask = oBitMask - 1;
+		oBitMask = ( PlaneBitMask )iMask;
+		memset( m_pPixels[ iMask ],0,sizeof( m_pPixels[ iMask ] ) );
+	}
+	m_bDirtyFrame = true;
+}
+
+template< bool bWrapping >
+void FrameBuffer::DrawPixelAtPos( const Chip8& oCpu,const uint8_t xStartingPos, const uint8_t yStartingPos,uint8_t N,uint8_t& iVFFlag )
+{
+	uint8_t iBitMask = m_oCurrentBitMask - 1;
+	if( m_oCurrentBitMask == PlaneBitMask::BOTH )
+	{
+		if( m_iBitPlaneDrawIteration == 2 )
+			m_iBitPlaneDrawIteration = 0;
+		
+		iBitMask = m_iBitPlaneDrawIteration;
+	}
+	else if( m_oCurrentBitMask == PlaneBitMask::NONE )
+		return;
+
+	//Every row of the sprite in one fetch, both planes when both are drawn : 64 bytes at most for 16x16
+	uint8_t aSprite[ 64 ];
+	const uint32_t iPlaneBytes = N == 0 ? 32 : N;
+	oCpu.ReadMemoryBlock( oCpu.GetI(),aSprite,m_oCurrentBitMask == PlaneBitMask::BOTH ? iPlaneBytes * 2 : iPlaneBytes );
+
+	uint8_t iCurrentX = xStartingPos & ( m_iDisplayWidth - 1 );
+	uint8_t iCurrentY = yStartingPos & ( m_iDisplayHeight - 1 );
+
+	int iSpriteSize = 8;
+	if( N == 0 )
+	{
+		uint8_t iIndex = m_iDisplayWidth == 64 ? 1 : 0;
+		uint8_t iIndex2 = iIndex == 0 ? 1 : 0;
+
+		iSpriteSize = 16;
+		for( uint8_t iYOffset = 0; iYOffset < 16; ++iYOffset,++iCurrentY )
+		{
+			if( !bWrapping )
+			{
+				if( iCurrentY >= m_iDisplayHeight )
+					return;
+			}
+			else if( bWrapping )
+				iCurrentY &= ( m_iDisplayHeight - 1 );
+
+			uint16_t iMemoryValue = aSprite[ iYOffset * 2 ] << 8 | aSprite[ iYOffset * 2 + 1 ];
+			if( m_oCurrentBitMask == PlaneBitMask::BOTH && iBitMask == 1 )
+			{
+				uint16_t iMemoryOffset = 32; //32 : 16 * 2
+				iMemoryValue = aSprite[ iMemoryOffset + ( iYOffset * 2 ) ] << 8 | aSprite[ iMemoryOffset + ( iYOffset * 2 ) + 1 ];
+			}
+
+			uint64_t iLine = static_cast< uint64_t >( iMemoryValue ) << 48;
+
+			uint64_t iPreviousValue = m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ];
+			uint64_t iPreviousValue2 = m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ];
+
+			//Check in wich block we are, or if both
+			if( iCurrentX < 64 && iCurrentX + iSpriteSize >= 64 )
+			{
+				if( m_iDisplayWidth > 64 )
+				{
+					int xShift = iCurrentX + iSpriteSize;
+					int iAns = xShift - 64;
+
+					uint64_t iLine2 = iLine;
+					iLine <<= ( iSpriteSize - iAns );
+					iLine2 >>= iCurrentX;
+
+					iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] & iLine ) || ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] & iLine2 ) ? 1 : 0;
+
+					m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] ^= iLine;
+					m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] ^= iLine2;
+				}
+				else
+				{
+					if( bWrapping )
+						iLine = iLine >> iCurrentX | iLine << ( m_iDisplayWidth - iCurrentX );
+					else
+						iLine >>= iCurrentX;
+
+					m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] ^= iLine;
+				}
+
+				m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] ) || ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] );
+			}
+			else if( iCurrentX < 64 )
+			{
+				iLine >>= iCurrentX;
+
+				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] & iLine ) ? 1 : 0;
+				m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] ^= iLine;
+
+				m_bDirtyFrame |= ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] );
+			}
+			else if( iCurrentX >= 64 )
+			{
+				iLine >>= ( iCurrentX - 64 );
+
+				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] & iLine ) ? 1 : 0;
+				m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] ^= iLine;
+
+				if( bWrapping )
+				{
+					int xShift = iCurrentX + iSpriteSize;
+					if( xShift >= m_iDisplayWidth )
+					{
+						int iAns = xShift - 64;
+
+						uint64_t iLine2 = static_cast< uint64_t >( iMemoryValue ) << 48;
+						iLine2 <<= ( iSpriteSize - iAns );
+
+						iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] & iLine2 ) ? 1 : 0;
+						m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] ^= iLine2;
+					}
+				}
+
+				m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex ] ) || ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ iIndex2 ] );
+			}
+		}
+
+		if( m_oCurrentBitMask == PlaneBitMask::BOTH )
+		{
+			++m_iBitPlaneDrawIteration;
+			if( m_iBitPlaneDrawIteration != 2 )
+				DrawPixelAtPos< bWrapping >( oCpu,xStartingPos,yStartingPos,N,iVFFlag );
+		}
+		return;
+	}
+
+	for( uint8_t iYOffset = 0; iYOffset < N; ++iYOffset, ++iCurrentY )
+	{
+		if( !bWrapping )
+		{
+			if( iCurrentY >= m_iDisplayHeight )
+				return;
+		}
+		else if( bWrapping )
+			iCurrentY &= ( m_iDisplayHeight - 1 );
+
+		uint16_t iMemoryValue = 0;
+		uint64_t iLine = 0;
+
+		uint16_t iMemoryOffset = iYOffset;
+		if( m_oCurrentBitMask == PlaneBitMask::BOTH && iBitMask == 1 )
+			iMemoryOffset = N + iYOffset;
+
+		if( GetResolutionMode() != ResolutionMode::HIRES )
+		{
+			uint64_t iPreviousValue = m_pPixels[ iBitMask ][ iCurrentY ][ 0 ];
+
+			iMemoryValue = aSprite[ iMemoryOffset ];
+			iLine = static_cast<uint64_t>( iMemoryValue ) << 56; //Store as big endian in ram
+
+			if( iCurrentX != 0 )
+			{
+				if( bWrapping )
+					iLine = iLine >> iCurrentX | iLine << ( m_iDisplayWidth - iCurrentX );
+				else
+					iLine >>= iCurrentX;
+			}
+
+			iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] & iLine ) ? 1 : 0;
+			m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ^= iLine;
+ 			m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] );
+		}
+		else
+		{
+			iMemoryValue = aSprite[ iMemoryOffset ];
+
+			iLine = static_cast< uint64_t >( iMemoryValue ) << 56; //Store as big endian in ram
+
+			uint64_t iPreviousValue = m_pPixels[ iBitMask ][ iCurrentY ][ 0 ];
+			uint64_t iPreviousValue2 = m_pPixels[ iBitMask ][ iCurrentY ][ 1 ];
+
+			//Check in which block we are, or if both
+			if( iCurrentX < 64 && iCurrentX + iSpriteSize >= 64 )
+			{
+				int xShift = iCurrentX + iSpriteSize;
+				int iAns = xShift - 64;
+
+				uint64_t iLine2 = iLine;
+				iLine  <<= ( iSpriteSize - iAns );
+				iLine2 >>= iCurrentX;
+
+				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] & iLine ) || ( m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] & iLine2 ) ? 1 : 0;
+
+				m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ^= iLine;
+				m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] ^= iLine2;
+
+				m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ) || ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] );
+			}
+			else if( iCurrentX < 64 )
+			{
+				iLine >>= iCurrentX;
+
+				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] & iLine ) ? 1 : 0;
+				m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] ^= iLine;
+
+				m_bDirtyFrame |= iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ 1 ];
+			}
+			else if( iCurrentX >= 64 )
+			{
+				iLine >>= ( iCurrentX - 64 );
+
+				iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] & iLine ) ? 1 : 0;
+				m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ^= iLine;
+
+				if( bWrapping )
+				{
+					int xShift = iCurrentX + iSpriteSize;
+					if( xShift >= m_iDisplayWidth )
+					{
+						int iAns = xShift - 64;
+						uint64_t iOverflow = static_cast< uint64_t >( iMemoryValue ) << 56;
+						iOverflow <<= ( iSpriteSize - iAns );
+						iVFFlag |= ( m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] & iOverflow ) ? 1 : 0;
+						m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] ^= iOverflow;
+					}
+				}
+
+				m_bDirtyFrame |= ( iPreviousValue != m_pPixels[ iBitMask ][ iCurrentY ][ 0 ] ) || ( iPreviousValue2 != m_pPixels[ iBitMask ][ iCurrentY ][ 1 ] );
+			}
+		}
+	}
+
+	if( m_oCurrentBitMask == PlaneBitMask::BOTH )
+	{
+		++m_iBitPlaneDrawIteration;
+		if( m_iBitPlaneDrawIteration < 2 )
+			DrawPixelAtPos< bWrapping >( oCpu,xStartingPos, yStartingPos, N,iVFFlag );
+	}
+}
+
+template void FrameBuffer::DrawPixelAtPos< false >( const Chip8& oCpu,const uint8_t xStartingPos,const uint8_t yStartingPos,uint8_t N,uint8_t& iVFFlag );
+template void FrameBuffer::DrawPixelAtPos< true >( const Chip8& oCpu,const uint8_t xStartingPos,const uint8_t yStartingPos,uint8_t N,uint8_t& iVFFlag );
+
+void FrameBuffer::ScrollVertical( uint8_t N,const bool bDown,const bool bLegacyScrolling )
+{
+	uint8_t iBitMask = m_oCurrentBitMask - 1;
+	if( m_oCurrentBitMask == PlaneBitMask::BOTH )
+	{
+		if( m_iBitPlaneDrawIteration == 2 )
+			m_iBitPlaneDrawIteration = 0;
+
+		iBitMask = m_iBitPlaneDrawIteration;
+	}
+	else if( m_oCurrentBitMask == PlaneBitMask::NONE )
+		return;
+
+	if( bDown )
+	{
+		N = bLegacyScrolling ? N / 2 : N;
+		for( int k = m_iDisplayHeight - 1; k >= 0; --k )
+		{
+			int iIndex = k - N;
+			if( iIndex < 0 )
+			{
+				m_pPixels[ iBitMask ][ k ][ 0 ] = 0; //Clip
+				if( GetResolutionMode() == ResolutionMode::HIRES )
+					m_pPixels[ iBitMask ][ k ][ 1 ] = 0;
+			}
+			else
+			{
+				m_pPixels[ iBitMask ][ k ][ 0 ] = m_pPixels[ iBitMask ][ iIndex ][ 0 ];
+				if( GetResolutionMode() == ResolutionMode::HIRES )
+					m_pPixels[ iBitMask ][ k ][ 1 ] = m_pPixels[ iBitMask ][ iIndex ][ 1 ];
+			}
+		}
+	}
+	else
+	{
+		for( int k = 0; k < m_iDisplayHeight; ++k )
+		{
+			int iIndex = k + N;
+			if( iIndex < m_iDisplayHeight )
+			{
+				m_pPixels[ iBitMask ][ k ][ 0 ] = m_pPixels[ iBitMask ][ iIndex ][ 0 ];
+				if( GetResolutionMode() == ResolutionMode::HIRES )
+					m_pPixels[ iBitMask ][ k ][ 1 ] = m_pPixels[ iBitMask ][ iIndex ][ 1 ];
+			}
+			else
+			{
+				m_pPixels[ iBitMask ][ k ][ 0 ] = 0; //Clip
+				if( GetResolutionMode() == ResolutionMode::HIRES )
+					m_pPixels[ iBitMask ][ k ][ 1 ] = 0;
+			}
+		}
+	}
+
+	if( m_oCurrentBitMask == PlaneBitMask::BOTH )
+	{
+		++m_iBitPlaneDrawIteration;
+		if( m_iBitPlaneDrawIteration < 2 )
+			ScrollVertical( N,bDown,bLegacyScrolling );
+	}
+}
+
+void FrameBuffer::ScrollHorizontal( const bool bLeft,const bool bLegacyScrolling )
+{
+	uint8_t iBitMask = m_oCurrentBitMask - 1;
+	if( m_oCurrentBitMask == PlaneBitMask::BOTH )
+	{
+		if( m_iBitPlaneDrawIteration == 2 )
+			m_iBitPlaneDrawIteration = 0;
+
+		iBitMask = m_iBitPlaneDrawIteration;
+	}
+	else if( m_oCurrentBitMask == PlaneBitMask::NONE )
+		return;
+
+	uint8_t iScrollValue = bLegacyScrolling ? 2 : 4;
+	for( int k = 0; k < m_iDisplayHeight; ++k )
+	{
+		if( GetResolutionMode() == ResolutionMode::LORES )
+			bLeft ? m_pPixels[ iBitMask ][ k ][ 0 ] <<= iScrollValue : m_pPixels[ iBitMask ][ k ][ 0 ] >>= iScrollValue;
+		else
+		{
+			//Check if we push outside the block
+			if( bLeft )
+			{
+				uint8_t iBlockErase = ( m_pPixels[ iBitMask ][ k ][ 0 ] >> 60 ) & 0xF;
+
+				m_pPixels[ iBitMask ][ k ][ 0 ] <<= iScrollValue;
+				m_pPixels[ iBitMask ][ k ][ 1 ] = ( m_pPixels[ iBitMask ][ k ][ 1 ] << iScrollValue ) | iBlockErase;
+			}
+			else
+			{
+				uint64_t iBlockErase = m_pPixels[ iBitMask ][ k ][ 1 ] & 0xF;
+
+				m_pPixels[ iBitMask ][ k ][ 1 ] >>= iScrollValue;
+				m_pPixels[ iBitMask ][ k ][ 0 ] = ( m_pPixels[ iBitMask ][ k ][ 0 ] >> iScrollValue ) | ( iBlockErase << 60 );
+			}
+		}
+	}
+
+	if( m_oCurrentBitMask == PlaneBitMask::BOTH )
+	{
+		++m_iBitPlaneDrawIteration;
+		if( m_iBitPlaneDrawIteration < 2 )
+			ScrollHorizontal( bLeft,bLegacyScrolling );
+	}
+}
+
+void FrameBuffer::SetResolution( const int iWidth,const int iHeight )
+{
+	if( m_iDisplayWidth == iWidth && m_iDisplayHeight == iHeight )
+		return;
+
+	m_iDisplayWidth = iWidth;
+	m_iDisplayHeight = iHeight;
+
+	m_bDirtyFrame = true;
+
+#ifdef DEBUG_INFO
+	std::cout << std::format( "DISPLAY::CHANGE_CURRENT_RESOLUTION_{}x{}",m_iDisplayWidth,m_iDisplayHeight ) << std::endl;
+#endif
+}
+
+void FrameBuffer::SetResolutionMode( const ResolutionMode oResolutionMode )
+{
+	//Keep res as power of two or instruction in draw opcode might give you exotic result
+	if( m_oResolutionMode != oResolutionMode )
+		m_oResolutionMode = oResolutionMode;
+
+	switch( m_oResolutionMode )
+	{
+	case ResolutionMode::HIRES:
+		SetResolution( 128,64 );
+		break;
+	case ResolutionMode::LORES:
+		SetResolution( 64,32 );
+		break;
+	default:
+		std::cerr << "Should not pass here with that value" << std::endl;
+		break;
+	}
+}
\ No newline at end of file
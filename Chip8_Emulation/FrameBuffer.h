@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+
+enum ResolutionMode
+{
+	LORES,
+	HIRES
+};
+
+enum PlaneBitMask
+{
+	NONE, //Can happen on xochip, we don't draw anything in this case
+	PLANE1, //By default for CHIP 8 / Superchip
+	PLANE2,
+	BOTH
+};
+
+class Chip8;
+//Guest screen, no GL here : the frontend only reads the pixels back when the frame is dirty
+class alignas( 16 ) FrameBuffer
+{
+public:
+	FrameBuffer();
+
+	void Reset();
+	void ClearScreen( const bool bReset = false );
+	template< bool bWrapping > //Known by the quirk specialization of the caller, no test left per sprite line
+	void DrawPixelAtPos( const Chip8& oCpu,const uint8_t xStartingPos,const uint8_t yStartingPos,const uint8_t N,uint8_t& iVFFlag );
+	void ScrollVertical( uint8_t N,const bool bDown,const bool bLegacyScrolling );
+	void ScrollHorizontal( const bool bLeft,const bool bLegacyScrolling );
+
+	void SetResolution( const int iWidth,const int iHeight );
+	void SetResolutionMode( const ResolutionMode oResolutionMode );
+	ResolutionMode GetResolutionMode() const { return m_oResolutionMode; }
+	void SetPlaneBitmask( const uint8_t oPlaneBitMask ) { m_oCurrentBitMask = ( PlaneBitMask )oPlaneBitMask; }
+
+	uint8_t GetWidth() const { return m_iDisplayWidth; }
+	uint8_t GetHeight() const { return m_iDisplayHeight; }
+
+	const uint64_t* GetPixels() const { return &m_pPixels[ 0 ][ 0 ][ 0 ]; }
+	bool IsDirty() const { return m_bDirtyFrame; }
+	void SetDirty( const bool bDirty ) { m_bDirtyFrame = bDirty; }
+
+private:
+	uint64_t							m_pPixels[ 2 ][ 64 ][ 2 ]; //bitmask || Width || 32Bit block
+
+	bool								m_bDirtyFrame;
+	uint8_t								m_iDisplayWidth;
+	uint8_t								m_iDisplayHeight;
+	uint8_t								m_iBitPlaneDrawIteration;
+
+	ResolutionMode						m_oResolutionMode;
+	PlaneBitMask						m_oCurrentBitMask;
+};
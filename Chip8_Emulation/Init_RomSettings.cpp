@@ -1,5 +1,8 @@
 #include "Init_RomSettings.h"
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
 #include "Chip8.h"
 #include "TinySHA1.hpp"
 #include "json.hpp"
@@ -10,21 +13,17 @@ using json = nlohmann::json;
 #define PROGRAMS_DEFAULT_FOLDER "programs.json"
 #define PLATFORMS_DEFAULT_FOLDER "platforms.json"
 
-static std::stringstream sHash;
-
-void Init_RomSettings::LookForDatabaseInfos( const char* memblock,const size_t& size )
+void Init_RomSettings::LookForDatabaseInfos( const char* memblock,const size_t& size,RomSettings& oSettings )
 {
 	//Calculate SHA1 of current ROM
 	int iIndex = _CalculateHash_RetrieveIndex( memblock,size );
+	oSettings.sHash = m_sHash.str();
 	if( iIndex == -1 )
-	{
-		Display::GetInstance()->AssignDisplaySettings( true );
 		return;
-	}
 
-	bool bSuccess = _LoadProgramsSettingsIsSuccesful( iIndex );
+	bool bSuccess = _LoadProgramsSettingsIsSuccesful( iIndex,oSettings );
 	if( !bSuccess )
-		Display::GetInstance()->AssignDisplaySettings();
+		oSettings.aColors.clear();
 }
 
 int Init_RomSettings::_CalculateHash_RetrieveIndex( const char* memblock,const size_t& size )
@@ -34,33 +33,31 @@ int Init_RomSettings::_CalculateHash_RetrieveIndex( const char* memblock,const s
 	uint32_t digest[ 5 ];
 	sSha.getDigest( digest );
 
-	sHash.str( std::string() );
-	sHash.clear();
+	m_sHash.str( std::string() );
+	m_sHash.clear();
 	for ( uint32_t i : digest )
-		sHash << std::hex << std::setw( 8 ) << std::setfill( '0' ) << i;
+		m_sHash << std::hex << std::setw( 8 ) << std::setfill( '0' ) << i;
 
 	return _FindIndex();
 }
 
 int Init_RomSettings::_FindIndex()
 {
-	static std::string sAbsolutePath;
-	if( sAbsolutePath.empty() )
-		sAbsolutePath = std::string( PATH_DATABASE ) + HASHES_DEFAULT_FOLDER;
+	static const std::string sAbsolutePath = std::string( PATH_DATABASE ) + HASHES_DEFAULT_FOLDER;
 	std::ifstream file( sAbsolutePath,std::ios::in );
 
 	if( file.is_open() )
 	{
 		json data = json::parse( file );
-		if( data.contains( sHash.str() ) )
+		if( data.contains( m_sHash.str() ) )
 		{
 			file.close();
 			file.clear();
-			return data[ sHash.str() ];
+			return data[ m_sHash.str() ];
 		}
 		else
 		{
-			std::cerr << "ERROR::DATABASE::HASH_NOT_FOUND : " << sHash.str() << std::endl;
+			std::cerr << "ERROR::DATABASE::HASH_NOT_FOUND : " << m_sHash.str() << std::endl;
 			file.close();
 			file.clear();
 		}
@@ -74,11 +71,9 @@ int Init_RomSettings::_FindIndex()
 	return -1;
 }
 
-bool Init_RomSettings::_LoadProgramsSettingsIsSuccesful( const int iIndex )
+bool Init_RomSettings::_LoadProgramsSettingsIsSuccesful( const int iIndex,RomSettings& oSettings )
 {
-	static std::string sProgramsAbsolutePath;
-	if( sProgramsAbsolutePath.empty() )
-		sProgramsAbsolutePath = std::string( PATH_DATABASE ) + PROGRAMS_DEFAULT_FOLDER;
+	static const std::string sProgramsAbsolutePath = std::string( PATH_DATABASE ) + PROGRAMS_DEFAULT_FOLDER;
 
 	std::ifstream file( sProgramsAbsolutePath,std::ios::in );
 	if( file.is_open() )
@@ -91,29 +86,29 @@ bool Init_RomSettings::_LoadProgramsSettingsIsSuccesful( const int iIndex )
 				std::cout << *it << '\n';
 			std::cout << std::endl;
 
-			Display::SetGameTitle( data[ iIndex ][ "title" ] );
-			if( data[ iIndex ][ "roms" ].contains( sHash.str() ) )
+			oSettings.sTitle = data[ iIndex ][ "title" ];
+			if( data[ iIndex ][ "roms" ].contains( m_sHash.str() ) )
 			{
 				//Tickrate
 				int iRomCustomTickrate = 0;
-				auto oRom = data[ iIndex ][ "roms" ][ sHash.str() ];
+				auto oRom = data[ iIndex ][ "roms" ][ m_sHash.str() ];
 				if( oRom.contains( "tickrate" ) )
 					iRomCustomTickrate = oRom[ "tickrate" ];
 
-				std::map<std::string,int> aKeys;
 				if( oRom.contains( "keys" ) )
-					aKeys = oRom[ "keys" ].get<std::map<std::string,int>>();
-				Input::GetInstance()->InitInputFromDatabase( aKeys );
+					oSettings.aKeys = oRom[ "keys" ].get<std::map<std::string,int>>();
+
+				//Not part of the upstream database, local entries can add the addresses their wait loops jump back to
+				if( oRom.contains( "idleLoops" ) )
+					oSettings.aIdleLoops = oRom[ "idleLoops" ].get<std::vector<uint16_t>>();
 
 				//Palette
-				std::vector<std::string > sColors;
 				if( oRom[ "colors" ].contains( "pixels" ) )
-					sColors = oRom[ "colors" ][ "pixels" ].get<std::vector<std::string>>();
-				Display::GetInstance()->AssignDisplaySettings( false, sColors );
+					oSettings.aColors = oRom[ "colors" ][ "pixels" ].get<std::vector<std::string>>();
 
 				//Platforms Specs
 				if( oRom.contains( "platforms" ) )
-					return ( _LoadPlatformsSettingsIsSuccesful( oRom[ "platforms" ].get<std::vector<std::string>>(),iRomCustomTickrate ) ); //Load specs if platform found
+					return ( _LoadPlatformsSettingsIsSuccesful( oRom[ "platforms" ].get<std::vector<std::string>>(),iRomCustomTickrate,oSettings ) ); //Load specs if platform found
 			}
 			else
 			{
@@ -139,7 +134,7 @@ bool Init_RomSettings::_LoadProgramsSettingsIsSuccesful( const int iIndex )
 	return true;
 }
 
-bool Init_RomSettings::_LoadPlatformsSettingsIsSuccesful( const std::vector<std::string >& sPlatforms,const int iRomCustomTickrate )
+bool Init_RomSettings::_LoadPlatformsSettingsIsSuccesful( const std::vector<std::string >& sPlatforms,const int iRomCustomTickrate,RomSettings& oSettings )
 {
 	auto sSupportPlatforms = Chip8::GetPlatformsSupported();
 	ptrdiff_t iSize = sSupportPlatforms->end() - sSupportPlatforms->begin();
@@ -149,7 +144,7 @@ bool Init_RomSettings::_LoadPlatformsSettingsIsSuccesful( const std::vector<std:
 		{
 			if( sPlatforms[ k ] == ( *it ) )
 			{
-				_LoadPlatformsSpecs( *it,iRomCustomTickrate );
+				_LoadPlatformsSpecs( *it,iRomCustomTickrate,oSettings );
 				std::cout << "LOAD_ROM_ON_::" << ( *it ) << std::endl;
 				return true;
 			}
@@ -159,15 +154,14 @@ bool Init_RomSettings::_LoadPlatformsSettingsIsSuccesful( const std::vector<std:
 			--it;
 	}
 	std::cerr << "ERROR::PLATFORM::NO_SUPPORT_PLATFORM_FOR_THIS_ROM" << std::endl;
-	Display::GetInstance()->SetResolution( 64, 32 );
+	oSettings.iWidth = 64;
+	oSettings.iHeight = 32;
 	return false;
 }
 
-void Init_RomSettings::_LoadPlatformsSpecs( const std::string& sPlatform,const int iRomCustomTickrate )
+void Init_RomSettings::_LoadPlatformsSpecs( const std::string& sPlatform,const int iRomCustomTickrate,RomSettings& oSettings )
 {
-	static std::string sPlatformsAbsolutePath;
-	if( sPlatformsAbsolutePath.empty() )
-		sPlatformsAbsolutePath = std::string( PATH_DATABASE ) + PLATFORMS_DEFAULT_FOLDER;
+	static const std::string sPlatformsAbsolutePath = std::string( PATH_DATABASE ) + PLATFORMS_DEFAULT_FOLDER;
 
 	std::ifstream file( sPlatformsAbsolutePath,std::ios::in );
 	if( file.is_open() )
@@ -177,6 +171,9 @@ void Init_RomSettings::_LoadPlatformsSpecs( const std::string& sPlatform,const i
 		{
 			if( oData.contains( "id" ) && oData[ "id" ] == sPlatform )
 			{
+				auto sSupportPlatforms = Chip8::GetPlatformsSupported();
+				oSettings.iPlatform = static_cast< int >( std::find( sSupportPlatforms->begin(),sSupportPlatforms->end(),sPlatform ) - sSupportPlatforms->begin() );
+
 				//Resolution
 				if( oData.contains( "displayResolutions" ) )
 				{
@@ -185,23 +182,22 @@ void Init_RomSettings::_LoadPlatformsSpecs( const std::string& sPlatform,const i
 
 					if( xPos != std::string::npos )
 					{
-						int iWidth = std::stoi( sRes.substr( 0,xPos ) );
-						int iHeight = std::stoi( sRes.substr( xPos + 1 ) );
-
-						Display::GetInstance()->SetResolution( iWidth,iHeight );
+						oSettings.iWidth = std::stoi( sRes.substr( 0,xPos ) );
+						oSettings.iHeight = std::stoi( sRes.substr( xPos + 1 ) );
 					}
 				}
-				Chip8::SetInstructionPerFrame( iRomCustomTickrate == 0 ? static_cast< int >( oData[ "defaultTickrate" ] ) : iRomCustomTickrate );
+				oSettings.iTickrate = iRomCustomTickrate == 0 ? static_cast< int >( oData[ "defaultTickrate" ] ) : iRomCustomTickrate;
 #ifndef OVERRIDE_DATABASE_QUIRKS
 				if( oData.contains( "quirks" ) )
 				{
-					Chip8::m_oCurrentQuirk.bShiftingFlag = oData[ "quirks" ].value( "shift",false );
-					Chip8::m_oCurrentQuirk.bMemoryUnchanged = oData[ "quirks" ].value( "memoryLeaveIUnchanged",false );
-					Chip8::m_oCurrentQuirk.bMemoryIncrementByX = oData[ "quirks" ].value( "memoryIncrementByX",false );
-					Chip8::m_oCurrentQuirk.bVFResetFlag = oData["quirks"].value( "logic",false );
-					Chip8::m_oCurrentQuirk.bDispWaitFlag = oData[ "quirks" ].value( "vblank", false );
-					Chip8::m_oCurrentQuirk.bWrapFlag = oData[ "quirks" ].value( "wrap",false );
-					Chip8::m_oCurrentQuirk.bQuirkJumpingFlag = oData[ "quirks" ].value( "jump",false );
+					oSettings.bHasQuirks = true;
+					oSettings.oQuirk.bShiftingFlag = oData[ "quirks" ].value( "shift",false );
+					oSettings.oQuirk.bMemoryUnchanged = oData[ "quirks" ].value( "memoryLeaveIUnchanged",false );
+					oSettings.oQuirk.bMemoryIncrementByX = oData[ "quirks" ].value( "memoryIncrementByX",false );
+					oSettings.oQuirk.bVFResetFlag = oData["quirks"].value( "logic",false );
+					oSettings.oQuirk.bDispWaitFlag = oData[ "quirks" ].value( "vblank", false );
+					oSettings.oQuirk.bWrapFlag = oData[ "quirks" ].value( "wrap",false );
+					oSettings.oQuirk.bQuirkJumpingFlag = oData[ "quirks" ].value( "jump",false );
 				}
 #endif
 				return;
@@ -1,18 +1,72 @@
 #pragma once
 #include <fstream>
 #include <vector>
+#include <string>
+#include <map>
+#include <sstream>
+#include <array>
+#include <cstdint>
+
+//#define OVERRIDE_DATABASE_QUIRKS //if def set values wanted below, otherwise there are erased by platforms specs quirks
+struct Quirk
+{
+	constexpr Quirk() {};
+	constexpr Quirk( bool bVFReset,bool bUnchanged,bool bIncrementByX,bool bDispWait,bool bWrap,bool bShifting,bool bJumping ) :
+		bVFResetFlag( bVFReset ),bMemoryUnchanged( bUnchanged ),bMemoryIncrementByX( bIncrementByX ),bDispWaitFlag( bDispWait ),bWrapFlag( bWrap ),bShiftingFlag( bShifting ),bQuirkJumpingFlag( bJumping ) {};
+	bool bVFResetFlag = true;
+	bool bMemoryUnchanged = false;
+	bool bMemoryIncrementByX = false;
+	bool bDispWaitFlag = true;
+	bool bWrapFlag = false;
+	bool bShiftingFlag = false;
+	bool bQuirkJumpingFlag = false;
+	bool bLegacySrolling = false; //Not a real quirk but serve if we want to simulate legacy superchip behavior - Need a manuel set
+
+	bool operator==( const Quirk& oOther ) const = default;
+};
+
+//Quirks of platforms.json, same order as Chip8::GetPlatformsSupported() : the interpreter is compiled once for each of them
+//					VFReset	Unchanged	IncrementByX	DispWait	Wrap	Shifting	Jumping
+constexpr std::array< Quirk,7 > PLATFORM_QUIRKS =
+{
+	Quirk( true,	false,		false,			true,		false,	false,		false ),	//originalChip8
+	Quirk( true,	false,		false,			true,		false,	false,		false ),	//hybridVIP
+	Quirk( false,	false,		false,			false,		false,	false,		false ),	//modernChip8
+	Quirk( true,	false,		false,			true,		false,	false,		false ),	//chip8x
+	Quirk( false,	false,		true,			false,		false,	true,		true ),		//chip48
+	Quirk( false,	true,		false,			false,		false,	true,		true ),		//superchip
+	Quirk( false,	false,		false,			false,		true,	false,		false )		//xochip
+};
+
+//What the database knows about the ROM, core only keeps it so the frontend can apply it on its side
+struct RomSettings
+{
+	std::string						sTitle;
+	std::string						sHash; //SHA1 of the ROM, filled even when the database is missing
+	std::vector<std::string>		aColors; //Empty means default palette
+	std::map<std::string,int>		aKeys;
+	int								iWidth = 64;
+	int								iHeight = 32;
+	int								iTickrate = 0; //0 keeps the current IPF
+	int								iPlatform = -1; //Index in PLATFORM_QUIRKS picked by _LoadPlatformsSpecs, -1 when unknown
+	bool							bHasQuirks = false;
+	Quirk							oQuirk;
+	std::vector<uint16_t>			aIdleLoops; //Speed hacks : start of the ROM wait loops, checked for skipping whatever their length
+};
 
 class Init_RomSettings
 {
 
 public:
-	void LookForDatabaseInfos( const char* memblock,const size_t& size );
+	void LookForDatabaseInfos( const char* memblock,const size_t& size,RomSettings& oSettings );
 
 private:
 	int _CalculateHash_RetrieveIndex( const char* memblock,const size_t& size );
 	int _FindIndex();
-	bool _LoadProgramsSettingsIsSuccesful( const int iIndex );
-	bool _LoadPlatformsSettingsIsSuccesful( const std::vector<std::string >& sPlatforms, const int iRomCustomTickrate );
-	void _LoadPlatformsSpecs( const std::string& sPlatform, const int iRomCustomTickrate );
+	bool _LoadProgramsSettingsIsSuccesful( const int iIndex,RomSettings& oSettings );
+	bool _LoadPlatformsSettingsIsSuccesful( const std::vector<std::string >& sPlatforms, const int iRomCustomTickrate,RomSettings& oSettings );
+	void _LoadPlatformsSpecs( const std::string& sPlatform, const int iRomCustomTickrate,RomSettings& oSettings );
 	void _ReturnAdditionnalInfoOnErrors( const std::ifstream& sfile );
+
+	std::stringstream m_sHash;
 };
\ No newline at end of file
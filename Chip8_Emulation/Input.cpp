@@ -1,11 +1,13 @@
 #include "Input.h"
+#include "TimeManager.h"
 
 Input* Input::m_pSingleton = nullptr;
 
 Input::Input()
 	: m_aInputs{ 0 },
 	m_bEnglishLayout( true ),
-	m_bOverride( true )
+	m_bOverride( true ),
+	m_bTurboKeyDown( false )
 {}
 
 Input::~Input()
@@ -25,6 +27,12 @@ void Input::ProcessInput( bool& quit )
 		if( glfwGetKey( pWindow,GLFW_KEY_ESCAPE ) == GLFW_PRESS )
 			glfwSetWindowShouldClose( pWindow,true );
 
+		//Tab toggles turbo on press
+		bool bTurboKey = glfwGetKey( pWindow,GLFW_KEY_TAB ) == GLFW_PRESS;
+		if( bTurboKey && !m_bTurboKeyDown )
+			TimeManager::SetTurbo( !TimeManager::IsTurbo() );
+		m_bTurboKeyDown = bTurboKey;
+
 		for( uint8_t i = 0; i < 16; ++i )
 			CheckInputState( i,pWindow );
 
@@ -34,6 +42,13 @@ void Input::ProcessInput( bool& quit )
 		quit = true;
 }
 
+bool Input::WaitForEvents( const double fTimeout )
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	glfwWaitEventsTimeout( fTimeout );
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() < fTimeout;
+}
+
 void Input::DestroyInputManager()
 {
 	delete m_pSingleton;
@@ -120,17 +135,6 @@ uint8_t Input::GetKeyState( uint8_t iIndex ) const
 		return m_aInputs[ iIndex ];
 }
 
-uint8_t Input::IsAnyKeyPress() const
-{
-	for( int i = 0; i < 16; ++i )
-	{
-		if( m_aInputs[ i ] )
-			return i;
-	}
-
-	return 0xFF;
-}
-
 void Input::CheckInputState( const uint8_t iKey, GLFWwindow* pWindow )
 {
 	int iKeyId = m_aKeyMap[ iKey ];
@@ -17,12 +17,13 @@ public:
 	}
 
 	void ProcessInput( bool& quit );
+	//Blocks until a window event or the timeout, true when an event woke it
+	bool WaitForEvents( const double fTimeout );
 	void DestroyInputManager();
 	void InitInputFromDatabase( std::map<std::string,int>& aKeys );
 	void InitInputDefault();
 
 	uint8_t GetKeyState( uint8_t iIndex ) const;
-	uint8_t	IsAnyKeyPress() const;
 
 private:
 
@@ -36,4 +37,5 @@ private:
 	uint8_t m_aInputs[ 0x10 ];
 	bool m_bEnglishLayout;
 	bool m_bOverride;
+	bool m_bTurboKeyDown;
 };
\ No newline at end of file
@@ -0,0 +1,415 @@
+#include "JitCompiler.h"
+#include "Chip8.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+#define JIT_CODE_BUFFER_SIZE ( 4 * 1024 * 1024 )
+
+//x86 register ids, only the volatile ones are used so the helper calls don't need any save
+#define REG_EAX 0
+#define REG_ECX 1
+#define REG_EDX 2
+
+//Jcc condition codes ( low nibble of 0F 8x )
+#define COND_E 0x4
+#define COND_NE 0x5
+
+using namespace MemoryMap;
+
+JitCompiler::JitCompiler() :
+	m_pCode( nullptr )
+	,m_iCapacity( 0 )
+	,m_iUsed( 0 )
+	,m_iPageSize( 4096 )
+	,m_pHelper( nullptr )
+{
+#ifdef JIT_X64_SUPPORTED
+#ifdef _WIN32
+	SYSTEM_INFO oSystemInfo;
+	GetSystemInfo( &oSystemInfo );
+	m_iPageSize = oSystemInfo.dwPageSize;
+	void* pMemory = VirtualAlloc( nullptr,JIT_CODE_BUFFER_SIZE,MEM_COMMIT | MEM_RESERVE,PAGE_READWRITE );
+#else
+	m_iPageSize = static_cast< size_t >( sysconf( _SC_PAGESIZE ) );
+	void* pMemory = mmap( nullptr,JIT_CODE_BUFFER_SIZE,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0 );
+	if( pMemory == MAP_FAILED )
+		pMemory = nullptr;
+#endif
+	if( pMemory == nullptr )
+		std::cerr << "ERROR::JIT::CANT_ALLOCATE_EXECUTABLE_MEMORY" << std::endl;
+	else
+	{
+		m_pCode = static_cast< uint8_t* >( pMemory );
+		m_iCapacity = JIT_CODE_BUFFER_SIZE;
+	}
+#endif
+	m_aBuffer.reserve( 1024 );
+}
+
+JitCompiler::~JitCompiler()
+{
+	if( m_pCode == nullptr )
+		return;
+
+#ifdef _WIN32
+	VirtualFree( m_pCode,0,MEM_RELEASE );
+#else
+	munmap( m_pCode,m_iCapacity );
+#endif
+}
+
+bool JitCompiler::IsSupported()
+{
+#ifdef JIT_X64_SUPPORTED
+	return true;
+#else
+	return false;
+#endif
+}
+
+JitCompiler::NativeBlock JitCompiler::Compile( const std::vector< uint16_t >& aOpcodes,const uint16_t iStartPC,const uint16_t iFollowingOpcode,const Quirk& oQuirk,const GuestLayout& oLayout,OpcodeHelper pHelper )
+{
+	if( m_pCode == nullptr || aOpcodes.empty() )
+		return nullptr;
+
+	m_aBuffer.clear();
+	m_pHelper = pHelper;
+
+	auto V = [ & ]( const uint8_t iIndex ) { return oLayout.iRegisters + iIndex * oLayout.iRegisterStride; };
+
+	//Prologue : keep rbx ( callee saved ) for the CPU pointer, 32 bytes of shadow space keep the stack aligned for the helper calls
+	_Emit8( 0x53 );													//push rbx
+	_Emit8( 0x48 ); _Emit8( 0x83 ); _Emit8( 0xEC ); _Emit8( 0x20 );	//sub rsp, 32
+#ifdef _WIN32
+	_Emit8( 0x48 ); _Emit8( 0x89 ); _Emit8( 0xCB );					//mov rbx, rcx
+#else
+	_Emit8( 0x48 ); _Emit8( 0x89 ); _Emit8( 0xFB );					//mov rbx, rdi
+#endif
+
+	uint32_t iPC = iStartPC;
+	int32_t iPCInMemory = iStartPC; //Value known to be stored in the guest PC, native opcodes never move it
+	bool bFlowHandled = false;
+	for( size_t i = 0; i < aOpcodes.size(); ++i )
+	{
+		const uint16_t iOpcode = aOpcodes[ i ];
+		const uint16_t iAddr = static_cast< uint16_t >( iPC );
+		iPC += iOpcode == 0xF000 ? 4 : 2;
+		const bool bLast = i + 1 == aOpcodes.size();
+
+		const uint8_t X = ( iOpcode & 0x0F00 ) >> 8;
+		const uint8_t Y = ( iOpcode & 0x00F0 ) >> 4;
+		const uint8_t N = iOpcode & 0x000F;
+		const uint8_t NN = iOpcode & 0x00FF;
+		const uint16_t NNN = iOpcode & 0x0FFF;
+
+		bool bNative = true;
+		switch( iOpcode & 0xF000 )
+		{
+		case 0x1000:
+			_StoreWordImm( oLayout.iPC,NNN );
+			bFlowHandled = true;
+			break;
+		case 0x3000:
+		case 0x4000:
+		case 0x5000:
+		case 0x9000:
+		{
+			const bool bRegisterCompare = ( iOpcode & 0xF000 ) == 0x5000 || ( iOpcode & 0xF000 ) == 0x9000;
+			if( !bLast || ( bRegisterCompare && N != 0 ) ) //5XY2 / 5XY3 are range stores / loads
+			{
+				bNative = false;
+				break;
+			}
+
+			_LoadByte( REG_EAX,V( X ) );
+			if( bRegisterCompare )
+			{
+				_LoadByte( REG_ECX,V( Y ) );
+				_Emit8( 0x38 ); _Emit8( 0xC8 );									//cmp al, cl
+			}
+			else
+			{
+				_Emit8( 0x3C ); _Emit8( NN );									//cmp al, NN
+			}
+
+			const bool bSkipIfEqual = ( iOpcode & 0xF000 ) == 0x3000 || ( iOpcode & 0xF000 ) == 0x5000;
+			const uint16_t iSkipPC = static_cast< uint16_t >( iPC + ( iFollowingOpcode == 0xF000 ? 4 : 2 ) );
+			size_t iNoSkip = _EmitJcc( bSkipIfEqual ? COND_NE : COND_E );
+			_StoreWordImm( oLayout.iPC,iSkipPC );
+			size_t iEnd = _EmitJmp();
+			_Patch( iNoSkip );
+			_StoreWordImm( oLayout.iPC,static_cast< uint16_t >( iPC ) );
+			_Patch( iEnd );
+			bFlowHandled = true;
+		}
+		break;
+		case 0x6000:
+			_StoreByteImm( V( X ),NN );
+			break;
+		case 0x7000:
+			_LoadByte( REG_EAX,V( X ) );
+			_Emit8( 0x04 ); _Emit8( NN );										//add al, NN
+			_StoreByte( REG_EAX,V( X ) );
+			break;
+		case 0x8000:
+		{
+			switch( N )
+			{
+			case 0x0:
+				_LoadByte( REG_EAX,V( Y ) );
+				_StoreByte( REG_EAX,V( X ) );
+				break;
+			case 0x1:
+			case 0x2:
+			case 0x3:
+			{
+				const uint8_t aOps[] = { 0x00,0x08,0x20,0x30 };					//-, or, and, xor
+				_LoadByte( REG_EAX,V( X ) );
+				_LoadByte( REG_ECX,V( Y ) );
+				_Emit8( aOps[ N ] ); _Emit8( 0xC8 );							//op al, cl
+				_StoreByte( REG_EAX,V( X ) );
+				if( oQuirk.bVFResetFlag )
+					_StoreByteImm( V( 0xF ),0 );
+			}
+			break;
+			case 0x4:
+			case 0x5:
+			case 0x7:
+			{
+				//VX is written before VF like the interpreter, matters when X is F
+				_LoadByte( REG_EAX,V( N == 0x7 ? Y : X ) );
+				_LoadByte( REG_ECX,V( N == 0x7 ? X : Y ) );
+				_Emit8( N == 0x4 ? 0x00 : 0x28 ); _Emit8( 0xC8 );				//add / sub al, cl
+				_Emit8( 0x0F ); _Emit8( N == 0x4 ? 0x92 : 0x93 ); _Emit8( 0xC2 );	//setc / setnc dl
+				_StoreByte( REG_EAX,V( X ) );
+				_StoreByte( REG_EDX,V( 0xF ) );
+			}
+			break;
+			case 0x6:
+			case 0xE:
+			{
+				_LoadByte( REG_EAX,V( oQuirk.bShiftingFlag ? X : Y ) );
+				_Emit8( 0x88 ); _Emit8( 0xC2 );									//mov dl, al
+				if( N == 0x6 )
+				{
+					_Emit8( 0x80 ); _Emit8( 0xE2 ); _Emit8( 0x01 );				//and dl, 1
+					_Emit8( 0xD0 ); _Emit8( 0xE8 );								//shr al, 1
+				}
+				else
+				{
+					_Emit8( 0xC0 ); _Emit8( 0xEA ); _Emit8( 0x07 );				//shr dl, 7
+					_Emit8( 0xD0 ); _Emit8( 0xE0 );								//shl al, 1
+				}
+				_StoreByte( REG_EAX,V( X ) );
+				_StoreByte( REG_EDX,V( 0xF ) );
+			}
+			break;
+			default:
+				bNative = false;
+				break;
+			}
+		}
+		break;
+		case 0xA000:
+			_StoreWordImm( oLayout.iI,NNN );
+			break;
+		case 0xF000:
+		{
+			switch( NN )
+			{
+			case 0x07:
+				_LoadByte( REG_EAX,oLayout.iDelayTimer );
+				_StoreByte( REG_EAX,V( X ) );
+				break;
+			case 0x15:
+				_LoadByte( REG_EAX,V( X ) );
+				_StoreByte( REG_EAX,oLayout.iDelayTimer );
+				break;
+			case 0x18:
+				_LoadByte( REG_EAX,V( X ) );
+				_StoreByte( REG_EAX,oLayout.iSoundTimer );
+				break;
+			case 0x1E:
+				_LoadWord( REG_EAX,oLayout.iI );
+				_LoadByte( REG_ECX,V( X ) );
+				_Emit8( 0x01 ); _Emit8( 0xC8 );									//add eax, ecx
+				_StoreWord( REG_EAX,oLayout.iI );
+				break;
+			case 0x29:
+				_LoadByte( REG_EAX,V( X ) );
+				_Emit8( 0x83 ); _Emit8( 0xE0 ); _Emit8( 0x0F );					//and eax, 0xF
+				_Emit8( 0x6B ); _Emit8( 0xC0 ); _Emit8( 0x05 );					//imul eax, eax, 5
+				_Emit8( 0x05 ); _Emit32( START_FONT_MEMORY_ADDRESS );				//add eax, font address
+				_StoreWord( REG_EAX,oLayout.iI );
+				break;
+			default:
+				bNative = false;
+				break;
+			}
+		}
+		break;
+		default:
+			bNative = false;
+			break;
+		}
+
+		if( bNative )
+			continue;
+
+		//Interpreter fallback : the handler expects PC on the opcode and moves it itself
+		if( iPCInMemory != iAddr )
+			_StoreWordImm( oLayout.iPC,iAddr );
+		_CallHelper( iOpcode );
+		iPCInMemory = static_cast< uint16_t >( iPC );
+		if( bLast )
+			bFlowHandled = true; //Whatever the handler did with PC is the truth
+	}
+
+	if( !bFlowHandled && iPCInMemory != static_cast< int32_t >( static_cast< uint16_t >( iPC ) ) )
+		_StoreWordImm( oLayout.iPC,static_cast< uint16_t >( iPC ) );
+	_StoreWordImm( oLayout.iCurrentOpcode,aOpcodes.back() ); //Read by the end of program detection
+
+	//Epilogue
+	_Emit8( 0x48 ); _Emit8( 0x83 ); _Emit8( 0xC4 ); _Emit8( 0x20 );	//add rsp, 32
+	_Emit8( 0x5B );													//pop rbx
+	_Emit8( 0xC3 );													//ret
+
+	if( m_iUsed + m_aBuffer.size() > m_iCapacity )
+		return nullptr;
+
+	//The page may already hold earlier blocks, none of them runs while a block is compiled
+	if( !_Protect( m_iUsed,m_aBuffer.size(),true ) )
+		return nullptr;
+	uint8_t* pBlock = m_pCode + m_iUsed;
+	memcpy( pBlock,m_aBuffer.data(),m_aBuffer.size() );
+	if( !_Protect( m_iUsed,m_aBuffer.size(),false ) )
+		return nullptr;
+	m_iUsed += m_aBuffer.size();
+	//16 bytes aligned entry points
+	m_iUsed = ( m_iUsed + 15 ) & ~static_cast< size_t >( 15 );
+
+	return reinterpret_cast< NativeBlock >( pBlock );
+}
+
+bool JitCompiler::_Protect( const size_t iOffset,const size_t iSize,const bool bWritable )
+{
+	const size_t iFirstPage = iOffset & ~( m_iPageSize - 1 );
+	const size_t iLength = ( ( iOffset + iSize + m_iPageSize - 1 ) & ~( m_iPageSize - 1 ) ) - iFirstPage;
+#ifdef _WIN32
+	DWORD iPreviousProtection = 0;
+	const bool bProtected = VirtualProtect( m_pCode + iFirstPage,iLength,bWritable ? PAGE_READWRITE : PAGE_EXECUTE_READ,&iPreviousProtection ) != 0;
+	if( bProtected && !bWritable )
+		FlushInstructionCache( GetCurrentProcess(),m_pCode + iOffset,iSize );
+#else
+	const bool bProtected = mprotect( m_pCode + iFirstPage,iLength,bWritable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC ) == 0;
+#endif
+	if( !bProtected )
+		std::cerr << "ERROR::JIT::CANT_PROTECT_CODE_BUFFER" << std::endl;
+	return bProtected;
+}
+
+void JitCompiler::_Emit16( const uint16_t iValue )
+{
+	_Emit8( iValue & 0xFF );
+	_Emit8( iValue >> 8 );
+}
+
+void JitCompiler::_Emit32( const uint32_t iValue )
+{
+	for( int i = 0; i < 4; ++i )
+		_Emit8( ( iValue >> ( i * 8 ) ) & 0xFF );
+}
+
+void JitCompiler::_Emit64( const uint64_t iValue )
+{
+	for( int i = 0; i < 8; ++i )
+		_Emit8( ( iValue >> ( i * 8 ) ) & 0xFF );
+}
+
+void JitCompiler::_EmitModRM( const uint8_t iReg,const int32_t iDisp )
+{
+	_Emit8( 0x80 | ( iReg << 3 ) | 0x3 ); //mod 10 ( disp32 ), rm rbx
+	_Emit32( static_cast< uint32_t >( iDisp ) );
+}
+
+void JitCompiler::_LoadByte( const uint8_t iReg,const int32_t iDisp )
+{
+	_Emit8( 0x0F ); _Emit8( 0xB6 );		//movzx r32, byte [rbx + disp]
+	_EmitModRM( iReg,iDisp );
+}
+
+void JitCompiler::_StoreByte( const uint8_t iReg,const int32_t iDisp )
+{
+	_Emit8( 0x88 );						//mov byte [rbx + disp], r8
+	_EmitModRM( iReg,iDisp );
+}
+
+void JitCompiler::_StoreByteImm( const int32_t iDisp,const uint8_t iValue )
+{
+	_Emit8( 0xC6 );						//mov byte [rbx + disp], imm8
+	_EmitModRM( 0,iDisp );
+	_Emit8( iValue );
+}
+
+void JitCompiler::_LoadWord( const uint8_t iReg,const int32_t iDisp )
+{
+	_Emit8( 0x0F ); _Emit8( 0xB7 );		//movzx r32, word [rbx + disp]
+	_EmitModRM( iReg,iDisp );
+}
+
+void JitCompiler::_StoreWord( const uint8_t iReg,const int32_t iDisp )
+{
+	_Emit8( 0x66 ); _Emit8( 0x89 );		//mov word [rbx + disp], r16
+	_EmitModRM( iReg,iDisp );
+}
+
+void JitCompiler::_StoreWordImm( const int32_t iDisp,const uint16_t iValue )
+{
+	_Emit8( 0x66 ); _Emit8( 0xC7 );		//mov word [rbx + disp], imm16
+	_EmitModRM( 0,iDisp );
+	_Emit16( iValue );
+}
+
+size_t JitCompiler::_EmitJcc( const uint8_t iCondition )
+{
+	_Emit8( 0x0F ); _Emit8( 0x80 | iCondition );
+	size_t iOffset = m_aBuffer.size();
+	_Emit32( 0 );
+	return iOffset;
+}
+
+size_t JitCompiler::_EmitJmp()
+{
+	_Emit8( 0xE9 );
+	size_t iOffset = m_aBuffer.size();
+	_Emit32( 0 );
+	return iOffset;
+}
+
+void JitCompiler::_Patch( const size_t iJumpOffset )
+{
+	uint32_t iRelative = static_cast< uint32_t >( m_aBuffer.size() - ( iJumpOffset + 4 ) );
+	memcpy( &m_aBuffer[ iJumpOffset ],&iRelative,sizeof( iRelative ) );
+}
+
+void JitCompiler::_CallHelper( const uint32_t iOpcode )
+{
+#ifdef _WIN32
+	_Emit8( 0x48 ); _Emit8( 0x89 ); _Emit8( 0xD9 );		//mov rcx, rbx
+	_Emit8( 0xBA ); _Emit32( iOpcode );					//mov edx, opcode
+#else
+	_Emit8( 0x48 ); _Emit8( 0x89 ); _Emit8( 0xDF );		//mov rdi, rbx
+	_Emit8( 0xBE ); _Emit32( iOpcode );					//mov esi, opcode
+#endif
+	_Emit8( 0x48 ); _Emit8( 0xB8 );						//mov rax, helper
+	_Emit64( reinterpret_cast< uint64_t >( m_pHelper ) );
+	_Emit8( 0xFF ); _Emit8( 0xD0 );						//call rax
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+	#define JIT_X64_SUPPORTED
+#endif
+
+struct Quirk;
+class Chip8;
+
+//Turns a translated block into x86-64 code working straight on the machine state
+//Only the register / timer / flow opcodes are emitted natively, everything else calls back the interpreter handler
+class JitCompiler
+{
+public:
+	typedef void ( *NativeBlock )( Chip8* pCpu );
+	typedef void ( *OpcodeHelper )( Chip8* pCpu,uint32_t iOpcode );
+
+	//Byte offsets of the guest state inside the Chip8 object, filled by the CPU which owns the layout
+	struct GuestLayout
+	{
+		int32_t iRegisters = 0;
+		int32_t iRegisterStride = 0;
+		int32_t iI = 0;
+		int32_t iPC = 0;
+		int32_t iDelayTimer = 0;
+		int32_t iSoundTimer = 0;
+		int32_t iCurrentOpcode = 0;
+	};
+
+	JitCompiler();
+	~JitCompiler();
+
+	static bool IsSupported();
+
+	//aOpcodes is the block content starting at iStartPC, iFollowingOpcode the word right after it ( needed when a skip ends the block )
+	//Returns nullptr when the code buffer is full, Reset() it with the blocks using it
+	NativeBlock Compile( const std::vector< uint16_t >& aOpcodes,const uint16_t iStartPC,const uint16_t iFollowingOpcode,const Quirk& oQuirk,const GuestLayout& oLayout,OpcodeHelper pHelper );
+	void Reset() { m_iUsed = 0; }
+
+	size_t GetCodeSize() const { return m_iUsed; }
+
+private:
+	void _Emit8( const uint8_t iValue ) { m_aBuffer.push_back( iValue ); }
+	void _Emit16( const uint16_t iValue );
+	void _Emit32( const uint32_t iValue );
+	void _Emit64( const uint64_t iValue );
+
+	//[rbx + disp32] addressing, rbx holds the Chip8 pointer during the whole block
+	void _EmitModRM( const uint8_t iReg,const int32_t iDisp );
+	void _LoadByte( const uint8_t iReg,const int32_t iDisp );
+	void _StoreByte( const uint8_t iReg,const int32_t iDisp );
+	void _StoreByteImm( const int32_t iDisp,const uint8_t iValue );
+	void _LoadWord( const uint8_t iReg,const int32_t iDisp );
+	void _StoreWord( const uint8_t iReg,const int32_t iDisp );
+	void _StoreWordImm( const int32_t iDisp,const uint16_t iValue );
+	size_t _EmitJcc( const uint8_t iCondition );
+	size_t _EmitJmp();
+	void _Patch( const size_t iJumpOffset );
+	void _CallHelper( const uint32_t iOpcode );
+	//Pages are never writable and executable at once : RW while a block is copied in, RX once it is there
+	bool _Protect( const size_t iOffset,const size_t iSize,const bool bWritable );
+
+	uint8_t*					m_pCode; //Mapped RW, flipped to RX page by page as blocks are copied
+	size_t						m_iCapacity;
+	size_t						m_iUsed;
+	size_t						m_iPageSize;
+
+	std::vector< uint8_t >		m_aBuffer; //Current block, copied into m_pCode once complete
+	OpcodeHelper				m_pHelper;
+};
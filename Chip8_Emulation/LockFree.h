@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+//One writer, one reader, neither ever waits on the other
+
+//The writer fills its own buffer and swaps it with the middle one, the reader takes the middle one when it is fresh
+//The reader always gets the latest published value, the ones in between are dropped
+template< typename T >
+class TripleBuffer
+{
+public:
+	T&			GetWriteBuffer() { return m_aBuffers[ m_iWrite ]; }
+	void		Publish() { m_iWrite = m_iMiddle.exchange( m_iWrite | FRESH_BIT,std::memory_order_acq_rel ) & INDEX_MASK; }
+
+	//False when nothing was published since the last call, the read buffer is then unchanged
+	bool		Acquire()
+	{
+		if( ( m_iMiddle.load( std::memory_order_relaxed ) & FRESH_BIT ) == 0 )
+			return false;
+		m_iRead = m_iMiddle.exchange( m_iRead,std::memory_order_acq_rel ) & INDEX_MASK;
+		return true;
+	}
+	const T&	GetReadBuffer() const { return m_aBuffers[ m_iRead ]; }
+
+private:
+	static constexpr uint8_t FRESH_BIT = 0x4;
+	static constexpr uint8_t INDEX_MASK = 0x3;
+
+	std::array< T,3 >			m_aBuffers;
+	uint8_t						m_iWrite = 0;
+	uint8_t						m_iRead = 1;
+	alignas( 64 ) std::atomic< uint8_t >	m_iMiddle{ 2 };
+};
+
+//Bounded ring, a push on a full queue fails instead of blocking
+template< typename T,size_t iCapacity >
+class SpscQueue
+{
+	static_assert( ( iCapacity & ( iCapacity - 1 ) ) == 0,"Capacity must be a power of two" );
+
+public:
+	bool		Push( const T& oValue )
+	{
+		const size_t iTail = m_iTail.load( std::memory_order_relaxed );
+		if( iTail - m_iHead.load( std::memory_order_acquire ) == iCapacity )
+			return false;
+		m_aValues[ iTail & ( iCapacity - 1 ) ] = oValue;
+		m_iTail.store( iTail + 1,std::memory_order_release );
+		return true;
+	}
+
+	bool		Pop( T& oValue )
+	{
+		const size_t iHead = m_iHead.load( std::memory_order_relaxed );
+		if( iHead == m_iTail.load( std::memory_order_acquire ) )
+			return false;
+		oValue = m_aValues[ iHead & ( iCapacity - 1 ) ];
+		m_iHead.store( iHead + 1,std::memory_order_release );
+		return true;
+	}
+
+private:
+	std::array< T,iCapacity >	m_aValues;
+	alignas( 64 ) std::atomic< size_t >	m_iHead{ 0 };
+	alignas( 64 ) std::atomic< size_t >	m_iTail{ 0 };
+};
@@ -0,0 +1,149 @@
+#include "MachinePool.h"
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <algorithm>
+
+#ifdef _WIN32
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+#endif
+
+#define HUGE_PAGE_SIZE ( 2 * 1024 * 1024 )
+
+static size_t RoundUp( const size_t iSize,const size_t iAlignment )
+{
+	return ( iSize + iAlignment - 1 ) / iAlignment * iAlignment;
+}
+
+MachinePool::MachinePool( const size_t iCapacity,const bool bHugePages ) :
+	m_pRegion( nullptr )
+	,m_iRegionSize( 0 )
+	,m_iCapacity( 0 )
+	,m_iConstructed( 0 )
+	,m_iInUse( 0 )
+	,m_bHugePages( false )
+{
+	static_assert( sizeof( Chip8 ) % alignof( Chip8 ) == 0,"Slots are packed, each one has to start aligned" );
+	const size_t iSize = RoundUp( std::max< size_t >( iCapacity,1 ) * sizeof( Chip8 ),HUGE_PAGE_SIZE );
+	void* pMemory = nullptr;
+
+#ifdef _WIN32
+	//Needs the "Lock pages in memory" privilege, most accounts don't have it
+	const size_t iLargePage = GetLargePageMinimum();
+	if( bHugePages && iLargePage != 0 )
+	{
+		pMemory = VirtualAlloc( nullptr,RoundUp( iSize,iLargePage ),MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES,PAGE_READWRITE );
+		m_bHugePages = pMemory != nullptr;
+	}
+	if( pMemory == nullptr )
+		pMemory = VirtualAlloc( nullptr,iSize,MEM_COMMIT | MEM_RESERVE,PAGE_READWRITE );
+#else
+	//Pages are populated now, not on the first run of each machine
+	if( bHugePages )
+	{
+		pMemory = mmap( nullptr,iSize,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE,-1,0 );
+		m_bHugePages = pMemory != MAP_FAILED;
+	}
+	if( !m_bHugePages )
+	{
+		pMemory = mmap( nullptr,iSize,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE,-1,0 );
+#ifdef MADV_HUGEPAGE
+		//No reserved huge pages, transparent ones are the next best thing
+		if( bHugePages && pMemory != MAP_FAILED )
+			m_bHugePages = madvise( pMemory,iSize,MADV_HUGEPAGE ) == 0;
+#endif
+	}
+	if( pMemory == MAP_FAILED )
+		pMemory = nullptr;
+#endif
+
+	if( pMemory == nullptr )
+	{
+		std::cerr << "ERROR::POOL::CANT_ALLOCATE_REGION " << iSize << std::endl;
+		return;
+	}
+
+	m_pRegion = static_cast< uint8_t* >( pMemory );
+	m_iRegionSize = iSize;
+	m_iCapacity = iCapacity;
+	m_aReleased.reserve( iCapacity );
+}
+
+MachinePool::~MachinePool()
+{
+	for( size_t i = 0; i < m_iConstructed; ++i )
+		reinterpret_cast< Chip8* >( m_pRegion + i * sizeof( Chip8 ) )->~Chip8();
+
+	if( m_pRegion == nullptr )
+		return;
+
+#ifdef _WIN32
+	VirtualFree( m_pRegion,0,MEM_RELEASE );
+#else
+	munmap( m_pRegion,m_iRegionSize );
+#endif
+}
+
+Chip8* MachinePool::Acquire( const Chip8::KeyAccess& oKey,const char* sROMToLoad )
+{
+	Chip8* pCpu = nullptr;
+	if( !m_aReleased.empty() )
+	{
+		pCpu = m_aReleased.back();
+		m_aReleased.pop_back();
+	}
+	else if( m_iConstructed < m_iCapacity )
+	{
+		pCpu = new( m_pRegion + m_iConstructed * sizeof( Chip8 ) ) Chip8();
+		++m_iConstructed;
+	}
+	else
+	{
+		std::cerr << "ERROR::POOL::FULL " << m_iCapacity << " machines" << std::endl;
+		return nullptr;
+	}
+	++m_iInUse;
+
+	std::shared_ptr< const RomImage > pImage = _FindImage( sROMToLoad );
+	if( pImage == nullptr )
+	{
+		//First time this ROM is seen, the machine reads it and its image serves every next Acquire
+		pCpu->Init( oKey,sROMToLoad );
+		if( pCpu->GetRomImage()->pBytes == nullptr )
+		{
+			Release( pCpu );
+			return nullptr;
+		}
+		pImage = pCpu->GetRomImage();
+		m_aImages.push_back( pImage );
+	}
+
+	//Even right after the disk load : a recycled machine has to start from the same state as a new one
+	pCpu->Init( oKey,pImage );
+	return pCpu;
+}
+
+void MachinePool::Release( Chip8* pCpu )
+{
+	if( pCpu == nullptr )
+		return;
+
+	m_aReleased.push_back( pCpu );
+	--m_iInUse;
+}
+
+std::shared_ptr< const RomImage > MachinePool::_FindImage( const char* sROMToLoad ) const
+{
+	if( sROMToLoad == nullptr )
+		return nullptr;
+
+	for( const std::shared_ptr< const RomImage >& pImage : m_aImages )
+	{
+		if( strcmp( pImage->sPath.c_str(),sROMToLoad ) == 0 )
+			return pImage;
+	}
+	return nullptr;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Chip8.h"
+#include <vector>
+#include <memory>
+
+//Machines of a farm placed side by side in one region reserved up front
+//A released machine stays constructed in its slot with its buffers, the next Acquire loads over it : cycling short runs doesn't allocate
+class MachinePool
+{
+public:
+	//bHugePages asks the system for large pages and falls back to normal ones when it can't have them
+	MachinePool( const size_t iCapacity,const bool bHugePages = false );
+	~MachinePool();
+
+	MachinePool( const MachinePool& ) = delete;
+	MachinePool& operator=( const MachinePool& ) = delete;
+
+	//Loaded machine, nullptr when the pool is full or the ROM can't be read
+	//Only the first load of a ROM goes to the disk and the database, the following ones start from its image
+	Chip8*							Acquire( const Chip8::KeyAccess& oKey,const char* sROMToLoad );
+	void							Release( Chip8* pCpu );
+
+	size_t							GetCapacity() const { return m_iCapacity; }
+	size_t							GetInUse() const { return m_iInUse; }
+	size_t							GetRegionSize() const { return m_iRegionSize; }
+	bool							IsHugePageBacked() const { return m_bHugePages; }
+
+private:
+	std::shared_ptr< const RomImage > _FindImage( const char* sROMToLoad ) const;
+
+	uint8_t*						m_pRegion;
+	size_t							m_iRegionSize;
+	size_t							m_iCapacity;
+	size_t							m_iConstructed; //Slots holding a machine, used or released
+	size_t							m_iInUse;
+	bool							m_bHugePages;
+	std::vector< Chip8* >			m_aReleased;
+	std::vector< std::shared_ptr< const RomImage > > m_aImages; //Shared by the machines loaded from them, a recycled slot only takes a reference
+};
@@ -1,6 +1,8 @@
 #include "SoundManager.h"
 #include <iostream>
-#include "Chip8.h"
+#include <algorithm>
+#include "EmulationThread.h"
+#include <atomic>
 
 #define MINIAUDIO_IMPLEMENTATION
 #include "MiniAudio/miniaudio.h"
@@ -13,6 +15,7 @@
 static ma_audio_buffer	g_oAudioBuffer;
 static ma_waveform		g_oWaveForm;
 static bool				g_bPlaySound = false;
+static std::atomic< bool >	g_bMachineRunning{ false }; //Written by Manage, read by the device thread
 
 static float m_aAudioData[ CHUNK_SIZE ];
 
@@ -22,6 +25,9 @@ SoundManager::SoundManager()
 	: m_iPitch( 0 )
 	 ,m_fFloatingIndex( 0.0f )
 	 ,m_iAudioStateFlag( AudioState::AUDIO_BUFFER_EMPTY )
+	 ,m_bMuted( false )
+	 ,m_iPatternVersion( 0 )
+	 ,m_iPitchVersion( 0 )
 	 ,m_oDevice( nullptr )
 {
 
@@ -50,9 +56,23 @@ void SoundManager::DestroySoundManager()
 	delete m_pSingleton;
 }
 
-void SoundManager::Manage( const uint8_t iSoundTimer )
+void SoundManager::Manage( const MachineSnapshot& oSnapshot )
 {
-	if( iSoundTimer > 0 )
+	const AudioRegisters& oAudio = oSnapshot.oAudio;
+	if( oSnapshot.iPatternVersion != m_iPatternVersion )
+	{
+		LoadPatternInSoundBuffer( oAudio.aPattern );
+		m_iPatternVersion = oSnapshot.iPatternVersion;
+	}
+
+	if( oSnapshot.iPitchVersion != m_iPitchVersion )
+	{
+		CalculateAndSetNewPitch( oAudio.iPitch );
+		m_iPitchVersion = oSnapshot.iPitchVersion;
+	}
+
+	g_bMachineRunning = oSnapshot.IsRunning();
+	if( oAudio.bBuzzer && !m_bMuted )
 		Play_Sound();
 	else
 		Stop_Sound();
@@ -94,7 +114,8 @@ void SoundManager::OnReset()
 
 static void data_callback( ma_device* pDevice,void* pOutput,const void* pInput,ma_uint32 frameCount )
 {
-	bool bPause = !Chip8::GetInstance()->IsRunning();
+	//The machine state comes from the last snapshot managed, the device never reads the machine
+	bool bPause = !g_bMachineRunning;
 	if( !bPause )
 	{
 		SoundManager* pInstance = SoundManager::GetInstance();
@@ -150,6 +171,7 @@ void SoundManager::Init()
 					oDeviceConfig.playback.channels = 1;
 					oDeviceConfig.sampleRate = SAMPLE_RATE;
 					oDeviceConfig.dataCallback = data_callback;
+					oDeviceConfig.pUserData = nullptr;
 
 	if( ma_device_init( NULL,&oDeviceConfig,&m_oDevice ) != MA_SUCCESS )
 	{
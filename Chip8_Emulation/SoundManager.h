@@ -3,6 +3,8 @@
 
 #include "MiniAudio/miniaudio.h"
 
+struct MachineSnapshot;
+
 enum AudioState
 {
 	AUDIO_BUFFER_EMPTY = 1,
@@ -16,12 +18,14 @@ public:
 
 	void Init();
 	void DestroySoundManager();
-	void Manage( const uint8_t iSoundTimer );
+	void Manage( const MachineSnapshot& oSnapshot );
 	void LoadPatternInSoundBuffer( const uint8_t* aAudioPattern );
 	void CalculateAndSetNewPitch( const uint8_t iXValue );
 	void ClearAudioBuffer();
 	void OnReset();
 	void SetFloatingIndex( float fFloatingIndex ) { m_fFloatingIndex = fFloatingIndex; }
+	//The buzzer follows the machine at 60 Hz only, muted while it runs faster than real time
+	void SetMuted( bool bMuted ) { m_bMuted = bMuted; }
 
 	float GetFloatingIndex() const { return m_fFloatingIndex; }
 	float GetPitch() const { return m_iPitch; }
@@ -52,5 +56,8 @@ private:
 	int						m_iPitch;
 	float					m_fFloatingIndex;
 	AudioState				m_iAudioStateFlag;
+	bool					m_bMuted;
+	uint32_t				m_iPatternVersion; //Of the last pattern / pitch loaded from a snapshot
+	uint32_t				m_iPitchVersion;
 };
 
@@ -1,15 +1,43 @@
 #include "TimeManager.h"
 #include <thread>
+#include <algorithm>
+#include <cmath>
+#if defined(__linux__)
+#include <time.h>
+#include <cerrno>
+#endif
 
 using std::chrono::operator""ns;
 using namespace std::chrono;
 
-constexpr auto iEarlyWakeUp = 5555555ns; //Time to wake up early and busy wait the next frame
-constexpr int  iMaxTickLimit = 5;
+constexpr auto iInitialSlack = 1000000ns; //Until the first sleeps have been measured
+constexpr auto iSpinMargin = 200000ns; //Hybrid spins this much on top of the worst slack
+constexpr int  iSlackMeanWeight = 8; //Average over the last ~8 sleeps
+constexpr int  iSlackPeakDecay = 64; //The worst slack fades over ~64 sleeps
+constexpr uint32_t iFrameStatsRefresh = 60; //Percentiles recomputed once per second at 60 Hz
+constexpr auto iGuestFrame = TimeManager::s_iGuestFrame;
+constexpr uint32_t iMaxGuestFramesPerCall = 4; //Past that the host can't keep up, the late frames are dropped
+constexpr auto iSpeedWindow = 500000000ns; //Speed multiple averaged over half a second
 
-nanoseconds TimeManager::s_iAccumulator{0 };
+steady_clock_point TimeManager::s_iNextFrame = steady_clock::now();
 nanoseconds TimeManager::s_iCurrentTick{ 16666666ns };
 double TimeManager::s_iTimeLastFrame = 0;
+PacingMode TimeManager::s_oPacingMode = PacingMode::Sleep;
+bool TimeManager::s_bPresentEarly = false;
+nanoseconds TimeManager::s_iSlackMean{ iInitialSlack };
+nanoseconds TimeManager::s_iSlackPeak{ iInitialSlack };
+steady_clock_point TimeManager::s_iLastPresent = steady_clock::now();
+std::array< double,FRAME_TIME_WINDOW > TimeManager::s_aFrameTimes{};
+uint32_t TimeManager::s_iFrameTimeCount = 0;
+FrameTimeStats TimeManager::s_oFrameTimeStats;
+steady_clock_point TimeManager::s_iLastGuestFrame = steady_clock::now();
+nanoseconds TimeManager::s_iGuestAccumulator{ 0 };
+std::atomic< bool > TimeManager::s_bTurbo{ false };
+bool TimeManager::s_bTurboBatch = false;
+std::atomic< uint32_t > TimeManager::s_iTurboFrameSkip{ 0 };
+steady_clock_point TimeManager::s_iSpeedWindowStart = steady_clock::now();
+uint32_t TimeManager::s_iSpeedWindowFrames = 0;
+double TimeManager::s_fSpeedMultiple = 1.0;
 
 #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
 #include <immintrin.h>
@@ -23,45 +51,178 @@ inline void cpu_relax() { /* rien, ou std::this_thread::yield() en dernier recou
 void TimeManager::HandleTime( const steady_clock::time_point& start )
 {
 	steady_clock::time_point iTimeAfterMainLoop = steady_clock::now();
-	nanoseconds iElapsed { iTimeAfterMainLoop - start };
+	if( s_bTurboBatch ) //The batch already filled the tick
+	{
+		s_bTurboBatch = false;
+		s_iNextFrame = iTimeAfterMainLoop;
+		s_iTimeLastFrame = duration<double,std::milli>( iTimeAfterMainLoop - start ).count();
+		_RecordFrame( iTimeAfterMainLoop );
+		return;
+	}
 
-	nanoseconds iTimeToFill = ( s_iCurrentTick - iElapsed  );
-	if ( iTimeToFill >= iEarlyWakeUp ) // Still some time available, check if we can sleep
+	//A late frame restarts the schedule from now, the guest clock catches up on its own in ConsumeGuestFrames
+	if( IsPresentEarly() ) //Wake when the next guest frame is due, it is presented as soon as it has run
+		s_iNextFrame = std::max( s_iLastGuestFrame + ( iGuestFrame - s_iGuestAccumulator ),iTimeAfterMainLoop );
+	else
+		s_iNextFrame = std::max( s_iNextFrame + s_iCurrentTick,iTimeAfterMainLoop );
+
+	switch( s_oPacingMode )
 	{
-		nanoseconds iExtraTime = ( iTimeToFill - iEarlyWakeUp );
-		if ( s_iAccumulator > nanoseconds::zero() )
-		{
-			if ( s_iAccumulator > s_iCurrentTick * iMaxTickLimit ) //Too much we skip
-			{
-				iExtraTime		= s_iAccumulator = nanoseconds::zero();
-			}
-			else
+		case PacingMode::VSync:
+			if( iTimeAfterMainLoop - s_iLastPresent >= s_iCurrentTick / 2 ) //The swap did block, it is the pacing
 			{
-				if ( iTimeToFill >= s_iAccumulator )
-				{
-					iExtraTime = iTimeToFill - s_iAccumulator; //iTimeToFill can absorb the whole accumulator the next frame
-					s_iAccumulator = nanoseconds::zero();
-				}
-				else
-				{
-					s_iAccumulator -= iTimeToFill;
-					iExtraTime = nanoseconds::zero();
-				}
+				s_iNextFrame = iTimeAfterMainLoop;
+				break;
 			}
-		}
+			[[fallthrough]];
+		case PacingMode::Sleep:
+			_SleepUntil( s_iNextFrame - s_iSlackMean );
+			break;
+		case PacingMode::Hybrid:
+			_SleepUntil( s_iNextFrame - s_iSlackPeak - iSpinMargin );
+			while( steady_clock::now() < s_iNextFrame )
+				cpu_relax();
+			break;
+		default:
+			break;
+	}
+
+	const steady_clock_point iNow = steady_clock::now();
+	s_iTimeLastFrame = duration<double,std::milli>( iNow - start ).count();
+	_RecordFrame( iNow );
+}
+
+void TimeManager::RecordFrame( const steady_clock::time_point& start )
+{
+	const steady_clock_point iNow = steady_clock::now();
+	s_iNextFrame = iNow;
+	s_iTimeLastFrame = duration<double,std::milli>( iNow - start ).count();
+	_RecordFrame( iNow );
+}
 
-		std::this_thread::sleep_until( iTimeAfterMainLoop + iExtraTime );
+void TimeManager::_SleepUntil( const steady_clock_point& iTarget )
+{
+	const steady_clock_point iNow = steady_clock::now();
+	if( iTarget <= iNow )
+		return;
+
+#if defined(__linux__)
+	//steady_clock is CLOCK_MONOTONIC, an absolute deadline does not drift with the time spent getting here
+	const nanoseconds iDeadline = duration_cast<nanoseconds>( iTarget.time_since_epoch() );
+	timespec oDeadline;
+	oDeadline.tv_sec = static_cast< time_t >( iDeadline.count() / 1000000000 );
+	oDeadline.tv_nsec = static_cast< long >( iDeadline.count() % 1000000000 );
+	while( clock_nanosleep( CLOCK_MONOTONIC,TIMER_ABSTIME,&oDeadline,nullptr ) == EINTR ) {}
+#else
+	std::this_thread::sleep_until( iTarget );
+#endif
+
+	//How late the timer woke us, Sleep aims early by the average and Hybrid spins over the worst
+	const nanoseconds iSlack = std::max( nanoseconds::zero(),steady_clock::now() - iTarget );
+	s_iSlackMean += ( iSlack - s_iSlackMean ) / iSlackMeanWeight;
+	s_iSlackPeak = std::min( std::max( iSlack,s_iSlackPeak - s_iSlackPeak / iSlackPeakDecay ),s_iCurrentTick );
+}
+
+void TimeManager::_RecordFrame( const steady_clock_point& iNow )
+{
+	s_aFrameTimes[ s_iFrameTimeCount % FRAME_TIME_WINDOW ] = duration<double,std::milli>( iNow - s_iLastPresent ).count();
+	s_iLastPresent = iNow;
+	if( ++s_iFrameTimeCount % iFrameStatsRefresh != 0 )
+		return;
+
+	const size_t iSamples = std::min< size_t >( s_iFrameTimeCount,FRAME_TIME_WINDOW );
+	const double fTick = duration<double,std::milli>( s_iCurrentTick ).count();
+	std::array< double,FRAME_TIME_WINDOW > aFrames;
+	std::array< double,FRAME_TIME_WINDOW > aJitters;
+	for( size_t i = 0; i < iSamples; ++i )
+	{
+		aFrames[ i ] = s_aFrameTimes[ i ];
+		aJitters[ i ] = std::abs( s_aFrameTimes[ i ] - fTick );
 	}
 
-	while ( steady_clock::now() <= start + s_iCurrentTick )
+	auto Percentile = [ iSamples ]( std::array< double,FRAME_TIME_WINDOW >& aValues,const size_t iPercent )
 	{
-		cpu_relax();
-	}; //Busy waiting
+		const size_t iRank = std::min( iSamples - 1,( iSamples * iPercent ) / 100 );
+		std::nth_element( aValues.begin(),aValues.begin() + iRank,aValues.begin() + iSamples );
+		return aValues[ iRank ];
+	};
+
+	s_oFrameTimeStats.fFrameP50 = Percentile( aFrames,50 );
+	s_oFrameTimeStats.fFrameP99 = Percentile( aFrames,99 );
+	s_oFrameTimeStats.fFrameMax = *std::max_element( aFrames.begin(),aFrames.begin() + iSamples );
+	s_oFrameTimeStats.fJitterP50 = Percentile( aJitters,50 );
+	s_oFrameTimeStats.fJitterP99 = Percentile( aJitters,99 );
+	s_oFrameTimeStats.fJitterMax = *std::max_element( aJitters.begin(),aJitters.begin() + iSamples );
+	s_oFrameTimeStats.fSlack = duration<double,std::milli>( s_iSlackMean ).count();
+}
 
-	s_iTimeLastFrame = 	duration<double, std::milli> ( steady_clock::now() - start ).count();
+void TimeManager::SetPacingMode( const PacingMode oMode )
+{
+	s_oPacingMode = oMode;
+	s_iNextFrame = steady_clock::now();
+}
+
+void TimeManager::SetPresentEarly( const bool bPresentEarly )
+{
+	s_bPresentEarly = bPresentEarly;
+	s_iNextFrame = steady_clock::now();
 }
 
 void TimeManager::SetRefreshTick( const double& iTick )
 {
 	s_iCurrentTick = duration_cast<nanoseconds>( duration<double>( iTick ) );
 }
+
+uint32_t TimeManager::ConsumeGuestFrames()
+{
+	const steady_clock_point iNow = steady_clock::now();
+	s_iGuestAccumulator += iNow - s_iLastGuestFrame;
+	s_iLastGuestFrame = iNow;
+
+	uint32_t iFrames = static_cast< uint32_t >( s_iGuestAccumulator / iGuestFrame );
+	if( iFrames > iMaxGuestFramesPerCall )
+	{
+		s_iGuestAccumulator = nanoseconds::zero();
+		return iMaxGuestFramesPerCall;
+	}
+	s_iGuestAccumulator -= iGuestFrame * iFrames;
+	return iFrames;
+}
+
+void TimeManager::SetTurbo( const bool bTurbo )
+{
+	if( s_bTurbo.exchange( bTurbo ) == bTurbo )
+		return;
+	ResyncClocks();
+}
+
+void TimeManager::ResyncClocks()
+{
+	s_iLastGuestFrame = steady_clock::now();
+	s_iGuestAccumulator = nanoseconds::zero();
+	s_iNextFrame = s_iLastGuestFrame;
+	s_iLastPresent = s_iLastGuestFrame;
+}
+
+bool TimeManager::IsTurboBatchDone( const steady_clock_point& start,const uint32_t iFramesRun )
+{
+	s_bTurboBatch = true;
+	const uint32_t iFrameSkip = GetTurboFrameSkip();
+	if( iFrameSkip != 0 && iFramesRun >= iFrameSkip )
+		return true;
+	return steady_clock::now() - start >= s_iCurrentTick;
+}
+
+void TimeManager::CountGuestFrames( const uint32_t iFrames )
+{
+	s_iSpeedWindowFrames += iFrames;
+
+	const steady_clock_point iNow = steady_clock::now();
+	const nanoseconds iElapsed = iNow - s_iSpeedWindowStart;
+	if( iElapsed < iSpeedWindow )
+		return;
+
+	s_fSpeedMultiple = ( s_iSpeedWindowFrames * iGuestFrame.count() ) / static_cast< double >( iElapsed.count() );
+	s_iSpeedWindowFrames = 0;
+	s_iSpeedWindowStart = iNow;
+}
@@ -1,8 +1,35 @@
 #ifndef CHIP8_EMULATION_TIMEMANAGER_H
 #define CHIP8_EMULATION_TIMEMANAGER_H
 #include <chrono>
+#include <cstdint>
+#include <array>
+#include <atomic>
 
 typedef std::chrono::nanoseconds nanoseconds;
+typedef std::chrono::steady_clock::time_point steady_clock_point;
+
+#define FRAME_TIME_WINDOW 240 //Frames kept for the percentiles, 4 s at 60 Hz
+
+//How the host waits for the next refresh tick
+enum class PacingMode
+{
+	Sleep,		//Timer sleep only, woken early by the measured average slack, no core burnt
+	Hybrid,		//Timer sleep then spin for the worst slack seen, tightest ticks for a bit of CPU
+	VSync,		//The buffer swap blocks, timer sleep only when the swap does not
+	Count,
+};
+
+//Frame to frame time of the presents and its distance to the tick, in ms
+struct FrameTimeStats
+{
+	double	fFrameP50 = 0.0;
+	double	fFrameP99 = 0.0;
+	double	fFrameMax = 0.0;
+	double	fJitterP50 = 0.0;
+	double	fJitterP99 = 0.0;
+	double	fJitterMax = 0.0;
+	double	fSlack = 0.0; //Average timer overshoot
+};
 class TimeManager
 {
 public:
@@ -10,17 +37,66 @@ public:
 	TimeManager(){};
 	~TimeManager(){};
 
+	static constexpr nanoseconds s_iGuestFrame{ 16666667 }; //The guest always runs at 60 Hz
+
 	static void HandleTime( const std::chrono::steady_clock::time_point& start );
+	//Counts the frame without waiting, for a loop that waited on something else
+	static void RecordFrame( const std::chrono::steady_clock::time_point& start );
 
 	static const double* GetTimeLastFrame() { return &s_iTimeLastFrame; }
 	static nanoseconds* GetRefreshTick() { return &s_iCurrentTick; }
 
 	static void SetRefreshTick( const double& iTick );
 
+	static void SetPacingMode( const PacingMode oMode );
+	static PacingMode GetPacingMode() { return s_oPacingMode; }
+	static const FrameTimeStats& GetFrameTimeStats() { return s_oFrameTimeStats; }
+
+	//Present early : the loop wakes when a guest frame is done instead of on the refresh tick
+	//Does nothing with VSync pacing, the swap stays the wait
+	static void SetPresentEarly( const bool bPresentEarly );
+	static bool IsPresentEarly() { return s_bPresentEarly && s_oPacingMode != PacingMode::VSync; }
+
+	//Guest frames ( 60 Hz ) elapsed since the last call, whatever the host refresh is
+	static uint32_t ConsumeGuestFrames();
+	//Restarts the guest clock and the pacing from now, the time spent idle or in turbo is not caught up
+	static void ResyncClocks();
+
+	//Turbo : guest frames back to back, one present every N of them or once per refresh tick, no sleep
+	//With the emulation thread the frames run back to back there, every Nth one is published and the presents keep the refresh tick
+	static void SetTurbo( const bool bTurbo );
+	static bool IsTurbo() { return s_bTurbo.load( std::memory_order_relaxed ); } //Read by the emulation thread
+	static void SetTurboFrameSkip( const uint32_t iFrames ) { s_iTurboFrameSkip.store( iFrames,std::memory_order_relaxed ); }
+	static uint32_t GetTurboFrameSkip() { return s_iTurboFrameSkip.load( std::memory_order_relaxed ); } //Read by the emulation thread
+	static bool IsTurboBatchDone( const steady_clock_point& start,const uint32_t iFramesRun );
+
+	//Guest frames actually run against the wall clock, 1.0 is real time
+	static void CountGuestFrames( const uint32_t iFrames );
+	static double GetSpeedMultiple() { return s_fSpeedMultiple; }
+
 private:
-	static nanoseconds  s_iAccumulator;
+	static void _SleepUntil( const steady_clock_point& iTarget );
+	static void _RecordFrame( const steady_clock_point& iNow );
+
+	static steady_clock_point	s_iLastGuestFrame;
+	static nanoseconds			s_iGuestAccumulator;
+	static steady_clock_point	s_iNextFrame; //Deadline of the next present, a tick after the previous one
 	static nanoseconds	s_iCurrentTick;
 	static double		s_iTimeLastFrame;
+	static PacingMode	s_oPacingMode;
+	static bool			s_bPresentEarly;
+	static nanoseconds	s_iSlackMean;
+	static nanoseconds	s_iSlackPeak;
+	static steady_clock_point	s_iLastPresent;
+	static std::array< double,FRAME_TIME_WINDOW >	s_aFrameTimes;
+	static uint32_t		s_iFrameTimeCount;
+	static FrameTimeStats	s_oFrameTimeStats;
+	static std::atomic< bool >	s_bTurbo;
+	static bool			s_bTurboBatch; //The last loop ran a turbo batch, it already filled the tick
+	static std::atomic< uint32_t >	s_iTurboFrameSkip;
+	static steady_clock_point	s_iSpeedWindowStart;
+	static uint32_t		s_iSpeedWindowFrames;
+	static double		s_fSpeedMultiple;
 };
 
 
@@ -1,12 +1,17 @@
 #include "Chip8.h"
 #include "Display.h"
 #include <chrono>
+#include <iostream>
 #include "Input.h"
 #include "SoundManager.h"
 #include "Chip8_Debugger.h"
 #include "TimeManager.h"
+#include "EmulationThread.h"
 
-int Quit()
+#define IDLE_WAIT_TIMEOUT	0.25	//Seconds blocked on window events while idle, the window title and debugger still refresh
+#define IDLE_GRACE_FRAMES	6		//Frames paced normally after an event woke the idle loop, lets the UI settle
+
+int Quit( Chip8* pCpu )
 {
 	Display::KeyDisplayAccess oKeyDisplay;
 
@@ -18,11 +23,22 @@ int Quit()
 #endif
 
 	Display::GetInstance()->DestroyWindow( oKeyDisplay );
-	Chip8::GetInstance()->DestroyCpu();
+	delete pCpu;
 
 	return -1;
 }
 
+void ApplyRomSettings( const RomSettings& oSettings )
+{
+	Display::SetGameTitle( oSettings.sTitle );
+	Display::GetInstance()->AssignDisplaySettings( oSettings.aColors );
+
+	std::map<std::string,int> aKeys = oSettings.aKeys;
+	Input::GetInstance()->InitInputFromDatabase( aKeys );
+
+	SoundManager::GetInstance()->OnReset();
+}
+
 int main( int argc,char* argv[] )
 {
 	const char* sROMToLoad = nullptr;
@@ -31,32 +47,152 @@ int main( int argc,char* argv[] )
 
 	Chip8::KeyAccess oKey;
 	Display::KeyDisplayAccess oKeyDisplay;
-	Chip8* m_pCpuInstance = Chip8::GetInstance();
+	Chip8* m_pCpuInstance = new Chip8;
+
+	//--seed N : CXNN replays the same bytes on every run and reset, the clock seeds it otherwise
+	//--governor : IPF lowered to what the ROM needs, see Chip8::SetIpfGovernor
+	//--pacing sleep|hybrid|vsync : how the host waits for the refresh tick, see PacingMode
+	//--turbo [--turbo-skip N] : fast-forward from the start, one present every N guest frames ( 0 : once per refresh tick )
+	//--run-in-background : the guest keeps running while the window is unfocused or minimized
+	//--single-thread : main runs the guest frames itself between two presents, no emulation thread
+	//--present vsync|adaptive|immediate : what the buffer swap waits for ( vsync by default ), see PresentMode
+	//--present-early : a frame is shown as soon as the guest is done with it instead of on the refresh tick
+	bool bPauseInBackground = true;
+	bool bThreaded = true;
+	PresentMode oPresentMode = PresentMode::VSync;
+	for( int i = 2; i < argc; ++i )
+	{
+		if( std::string( argv[ i ] ) == "--seed" && i + 1 < argc )
+			m_pCpuInstance->SetRandomSeed( static_cast< uint32_t >( std::stoul( argv[ ++i ],nullptr,0 ) ) );
+		else if( std::string( argv[ i ] ) == "--governor" )
+			m_pCpuInstance->SetIpfGovernor( true );
+		else if( std::string( argv[ i ] ) == "--pacing" && i + 1 < argc )
+		{
+			const std::string sMode = argv[ ++i ];
+			if( sMode == "sleep" )
+				TimeManager::SetPacingMode( PacingMode::Sleep );
+			else if( sMode == "hybrid" )
+				TimeManager::SetPacingMode( PacingMode::Hybrid );
+			else if( sMode == "vsync" )
+				TimeManager::SetPacingMode( PacingMode::VSync );
+			else
+				std::cerr << "ERROR::MAIN::UNKNOWN_PACING_MODE " << sMode << std::endl;
+		}
+		else if( std::string( argv[ i ] ) == "--turbo" )
+			TimeManager::SetTurbo( true );
+		else if( std::string( argv[ i ] ) == "--turbo-skip" && i + 1 < argc )
+			TimeManager::SetTurboFrameSkip( static_cast< uint32_t >( std::stoul( argv[ ++i ] ) ) );
+		else if( std::string( argv[ i ] ) == "--run-in-background" )
+			bPauseInBackground = false;
+		else if( std::string( argv[ i ] ) == "--single-thread" )
+			bThreaded = false;
+		else if( std::string( argv[ i ] ) == "--present" && i + 1 < argc )
+		{
+			const std::string sMode = argv[ ++i ];
+			if( sMode == "vsync" )
+				oPresentMode = PresentMode::VSync;
+			else if( sMode == "adaptive" )
+				oPresentMode = PresentMode::Adaptive;
+			else if( sMode == "immediate" )
+				oPresentMode = PresentMode::Immediate;
+			else
+				std::cerr << "ERROR::MAIN::UNKNOWN_PRESENT_MODE " << sMode << std::endl;
+		}
+		else if( std::string( argv[ i ] ) == "--present-early" )
+			TimeManager::SetPresentEarly( true );
+	}
+	EmulationThread oEmulation( m_pCpuInstance );
 	Display* m_pDisplayInstance = Display::GetInstance();
 	Input* m_pInputInstance = Input::GetInstance();
+	m_pDisplayInstance->SetPresentMode( oPresentMode );
 
-	if( m_pDisplayInstance->Init( oKeyDisplay,m_pCpuInstance ) != 0 )
+	if( m_pDisplayInstance->Init( oKeyDisplay,&oEmulation ) != 0 )
 	{
-		Quit();
+		Quit( m_pCpuInstance );
 		return -1;
 	}
 
 	m_pCpuInstance->Init( oKey,sROMToLoad );
-	SoundManager::GetInstance()->Init();
+	SoundManager* m_pSoundManagerInstance = SoundManager::GetInstance();
+	m_pSoundManagerInstance->Init();
+	if( bThreaded )
+		oEmulation.Start();
 
+	uint32_t iLoadCount = 0;
+	uint64_t iGuestFrames = 0;
+	uint32_t iIdleGrace = 0;
 	bool quit = false;
 	while( !quit )
 	{
 		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-		//Emulator main loop
-		m_pCpuInstance->EmulateCycle( oKey );
+		//The emulation thread keeps the guest at 60 Hz on its own, main only shows the last snapshot it published
+		//In background the guest is frozen where it is, it does not catch up when the window comes back
+		const bool bBackground = bPauseInBackground && m_pDisplayInstance->IsInBackground();
+		oEmulation.SetSuspended( bBackground );
+		if( !oEmulation.IsThreaded() )
+		{
+			//Without it the guest frames run here, as many as the guest clock asks for since the last loop
+			//In turbo they run back to back and only the last one of the batch is presented
+			oEmulation.ApplyCommands( oKey );
+			if( !bBackground && TimeManager::IsTurbo() )
+			{
+				uint32_t iBatchFrames = 0;
+				while( oEmulation.RunFrame( oKey ) && !TimeManager::IsTurboBatchDone( start,++iBatchFrames ) ) {}
+			}
+			else if( !bBackground )
+			{
+				const uint32_t iDueFrames = TimeManager::ConsumeGuestFrames();
+				for( uint32_t iFrame = 0; iFrame < iDueFrames; ++iFrame )
+					oEmulation.RunFrame( oKey );
+			}
+			oEmulation.Publish();
+		}
+
+		const MachineSnapshot& oSnapshot = oEmulation.Acquire();
+		TimeManager::CountGuestFrames( static_cast< uint32_t >( oSnapshot.iGuestFrames - iGuestFrames ) );
+		iGuestFrames = oSnapshot.iGuestFrames;
+		if( iLoadCount != oSnapshot.iLoadCount ) //New ROM or reset, apply what the core found in the database
+		{
+			iLoadCount = oSnapshot.iLoadCount;
+			ApplyRomSettings( oSnapshot.pRom->oSettings );
+		}
+		m_pSoundManagerInstance->SetMuted( TimeManager::IsTurbo() || bBackground );
+		m_pSoundManagerInstance->Manage( oSnapshot );
+
+		//Nothing runs : block on the window events instead of pacing, render once per wake up
+		const bool bIdle = bBackground || oSnapshot.IsPause() || oSnapshot.IsStop();
+		if( bIdle && iIdleGrace == 0 )
+		{
+			if( m_pInputInstance->WaitForEvents( IDLE_WAIT_TIMEOUT ) )
+				iIdleGrace = IDLE_GRACE_FRAMES;
+		}
+		else if( iIdleGrace != 0 )
+			--iIdleGrace;
+
 		m_pInputInstance->ProcessInput(quit );
-		m_pDisplayInstance->Update( m_pCpuInstance->IsPause() );
+		uint16_t iKeys = 0;
+		for( uint8_t i = 0; i < 0x10; ++i )
+			iKeys |= ( m_pInputInstance->GetKeyState( i ) != 0 ) << i;
+		oEmulation.SetKeys( iKeys );
+
+		if( !m_pDisplayInstance->IsIconified() )
+			m_pDisplayInstance->Update( oSnapshot );
 
-		TimeManager::HandleTime( start );
+		if( bIdle && iIdleGrace == 0 )
+			TimeManager::ResyncClocks();
+		else if( bThreaded && TimeManager::IsPresentEarly() && !TimeManager::IsTurbo() && !bIdle )
+		{
+			//The thread publishes the moment the guest frame ends, the next loop presents it right away
+			//Two guest frames at most, the events are still processed if the guest stops publishing
+			oEmulation.WaitForPublish( oSnapshot.iSequence,TimeManager::s_iGuestFrame * 2 );
+			TimeManager::RecordFrame( start );
+		}
+		else
+			TimeManager::HandleTime( start );
 	}
 
-	Quit();
+	oEmulation.Stop();
+	Quit( m_pCpuInstance );
 	return 0;
 }
\ No newline at end of file